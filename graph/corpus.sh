@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# Generate the benchmark corpus into ./corpus with fixed seeds, every
+# family at the scale SCALE (1 by default, about 10^6 edges per graph).
+# The hard instances come with the mates of their bad initial matching,
+# pass them to the matching with --init.
+#
+# Usage: SCALE=10 ./corpus.sh [--binary]
+
+SCALE=${SCALE:-1}
+N=$((100000 * SCALE))
+SIDE=$((1000 * SCALE))
+DIR="corpus"
+
+make
+mkdir -p $DIR
+
+# random
+./generator er $N $N 0.0001 --seed 1 $1 > $DIR/er_$SCALE
+./generator chunglu $N $N 10 2.5 --seed 2 $1 > $DIR/chunglu_$SCALE
+./generator powerlaw $N $N 10 2.1 --seed 3 $1 > $DIR/powerlaw_$SCALE
+./generator rmat $N $N $((10 * N)) --seed 4 $1 > $DIR/rmat_$SCALE
+
+# structured
+./generator grid $SIDE $SIDE --seed 5 $1 > $DIR/grid_$SCALE
+./generator road $SIDE $SIDE 0.6 --seed 6 $1 > $DIR/road_$SCALE
+
+# hard
+./generator chain $((N / 2)) --mates $DIR/chain_$SCALE.mates $1 > $DIR/chain_$SCALE
+./generator hk $((400 * SCALE)) --mates $DIR/hk_$SCALE.mates $1 > $DIR/hk_$SCALE
+./generator conflict $N 10 $1 > $DIR/conflict_$SCALE
+
+ls -l $DIR
@@ -0,0 +1,456 @@
+/*
+ * Project: GAL 2014 - generator of bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Edges of the families. Nodes 0 .. n1-1 form the first side and
+ * n1 .. n1+n2-1 the second one.
+ *
+ * er N1 N2 P            every edge with the probability P, geometric skips
+ * chunglu N1 N2 D [G]   expected degrees of both sides by a power law with
+ *                       the exponent G (2.5), D edges per node of the first
+ *                       side, the skips of Miller and Hagberg
+ * powerlaw N1 N2 D [G]  the same with a uniform first side
+ * rmat N1 N2 M          M edges of R-MAT (0.57, 0.19, 0.19, 0.05), the edges
+ *                       may repeat and low ids are the hubs
+ * grid R C              the R x C lattice, black cells form the first side
+ * road R C [P]          the lattice with the edges kept with P (0.6)
+ * chain K               a path of 2K nodes, the perfect matching needs one
+ *                       augmenting path of 2K - 1 edges from its mates
+ * hk K                  paths of 1, 3, .. 2K - 1 edges, the mates leave one
+ *                       augmenting path of every length (Hopcroft-Karp)
+ * conflict N K          every node of the first side joins the same K hubs,
+ *                       all trees compete for them
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "generator.h"
+
+//------------------------------------------------------------------- RANDOM
+
+static uint64_t _nextRandom(uint64_t *state) {
+
+  // splitmix64
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+//-------------------------------------------------------------------
+
+static double _uniform(TChunk *chunk) {
+
+  // in (0, 1]
+  return ((_nextRandom(&(chunk->state)) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+//-------------------------------------------------------------------
+
+static uint64_t _skip(TChunk *chunk, double p, uint64_t left) {
+
+  // failures before the next success, at most left
+  double skip = floor(log(_uniform(chunk)) / log1p(-p));
+  return (skip < (double) left) ? (uint64_t) skip : left;
+}
+
+//------------------------------------------------------------------- WEIGHTS
+
+static double _powerSum(uint64_t n, double alpha) {
+
+  double sum = 0;
+
+  for (uint64_t k = n; k > 0; k--) {
+    sum += pow((double) k, -alpha);
+  }
+
+  return sum;
+}
+
+//-------------------------------------------------------------------
+
+static double _weight1(TGenerator *gen, uint64_t i) {
+  return (gen->family == CHUNGLU) ? gen->scale1 * pow((double) (i + 1), -gen->alpha) : gen->degree;
+}
+
+static double _weight2(TGenerator *gen, uint64_t j) {
+  return gen->scale2 * pow((double) (j + 1), -gen->alpha);
+}
+
+//------------------------------------------------------------------- INIT
+
+int initFamily(TGenerator *gen) {
+
+  double perUnit = 1;
+
+  switch (gen->family) {
+
+    case ER:
+      if (gen->p < 0 || gen->p > 1) return EPARAM;
+      gen->units = gen->n1;
+      perUnit = gen->n2 * gen->p;
+      break;
+
+    case CHUNGLU:
+    case POWERLAW:
+      if (gen->degree < 0 || gen->gamma <= 1) return EPARAM;
+
+      gen->alpha = 1 / (gen->gamma - 1);
+      gen->total = gen->degree * gen->n1;
+      gen->scale1 = (gen->n1 > 0) ? gen->total / _powerSum(gen->n1, gen->alpha) : 0;
+      gen->scale2 = (gen->n2 > 0) ? gen->total / _powerSum(gen->n2, gen->alpha) : 0;
+      gen->units = (gen->n2 > 0 && gen->total > 0) ? gen->n1 : 0;
+      perUnit = gen->degree;
+      break;
+
+    case RMAT:
+      gen->units = (gen->n1 > 0 && gen->n2 > 0) ? gen->edges : 0;
+      break;
+
+    case GRID:
+    case ROAD:
+      if (gen->p < 0 || gen->p > 1) return EPARAM;
+      gen->n1 = (gen->rows * gen->cols + 1) / 2;
+      gen->n2 = gen->rows * gen->cols / 2;
+      gen->units = gen->rows;
+      perUnit = 2.0 * gen->cols;
+      break;
+
+    case CHAIN:
+      gen->n1 = gen->n2 = gen->rows;
+      gen->units = gen->rows;
+      perUnit = 2;
+      break;
+
+    case HK:
+      gen->n1 = gen->n2 = gen->rows * (gen->rows + 1) / 2;
+      gen->units = gen->rows;
+      perUnit = gen->rows;
+      break;
+
+    case TREES:
+      gen->n2 = gen->cols;
+      gen->units = gen->n1;
+      perUnit = gen->cols;
+      break;
+
+    default:
+      return EPARAM;
+  }
+
+  // units of about a million expected edges
+  double units = CHUNK_EDGES / ((perUnit > 1) ? perUnit : 1);
+  gen->perChunk = (units < 1) ? 1 : ((units > gen->units) ? gen->units + 1 : (uint64_t) units);
+  gen->nchunks = (gen->units + gen->perChunk - 1) / gen->perChunk;
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+void initChunk(TGenerator *gen, TChunk *chunk, uint64_t index) {
+
+  uint64_t first = index * gen->perChunk;
+  uint64_t last = (first + gen->perChunk < gen->units) ? first + gen->perChunk : gen->units;
+
+  memset(chunk, 0, sizeof(TChunk));
+  chunk->state = gen->seed ^ (0xD1B54A32D192ED03ULL * (index + 1)) ^ ((uint64_t) gen->family << 56);
+  chunk->unit = first;
+  chunk->last = last;
+
+  // the cells of all rows of the chunk in one sequence
+  if (gen->family == ER) {
+    chunk->cells = (last - first) * gen->n2;
+    chunk->cell = (uint64_t) -1;
+  }
+
+  // black cells of a row start at its parity
+  if (gen->family == GRID || gen->family == ROAD) {
+    chunk->cell = first % 2;
+  }
+}
+
+//------------------------------------------------------------------- ER
+
+static int _nextER(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  if (gen->p <= 0) {
+    return 0;
+  }
+
+  // the gap to the next edge is geometric
+  uint64_t left = chunk->cells - chunk->cell;
+  uint64_t gap = 1 + ((gen->p < 1) ? _skip(chunk, gen->p, left) : 0);
+
+  chunk->cell += gap;
+
+  if (chunk->cell >= chunk->cells) {
+    return 0;
+  }
+
+  *x = chunk->unit + chunk->cell / gen->n2;
+  *y = gen->n1 + chunk->cell % gen->n2;
+  return 1;
+}
+
+//------------------------------------------------------------------- CHUNG-LU
+
+static int _nextChungLu(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  // weights of the second side decrease, a skip by the last probability
+  // is accepted by the ratio of the new one
+  for (; chunk->unit < chunk->last; chunk->unit++, chunk->sub = 0) {
+
+    double w = _weight1(gen, chunk->unit);
+
+    if (chunk->sub == 0) {
+      chunk->sub = 1;
+      chunk->cell = 0;
+      chunk->p = fmin(1, w * _weight2(gen, 0) / gen->total);
+    }
+
+    while (chunk->cell < gen->n2 && chunk->p > 0) {
+
+      if (chunk->p < 1) {
+        chunk->cell += _skip(chunk, chunk->p, gen->n2 - chunk->cell);
+      }
+
+      if (chunk->cell >= gen->n2) break;
+
+      double q = fmin(1, w * _weight2(gen, chunk->cell) / gen->total);
+      int accepted = (_uniform(chunk) <= q / chunk->p);
+
+      chunk->p = q;
+      chunk->cell++;
+
+      if (accepted) {
+        *x = chunk->unit;
+        *y = gen->n1 + chunk->cell - 1;
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------- R-MAT
+
+static int _bits(uint64_t n) {
+
+  int bits = 0;
+  while (bits < 64 && ((uint64_t) 1 << bits) < n) bits++;
+  return bits;
+}
+
+//-------------------------------------------------------------------
+
+static int _nextRMAT(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  const double a = 0.57, b = 0.19, c = 0.19;
+
+  if (chunk->unit >= chunk->last) {
+    return 0;
+  }
+
+  int bits1 = _bits(gen->n1), bits2 = _bits(gen->n2);
+  int levels = (bits1 > bits2) ? bits1 : bits2;
+
+  // quadrants of the matrix down to a cell, cells out of the sides again
+  do {
+    *x = 0;
+    *y = 0;
+
+    for (int l = 0; l < levels; l++) {
+
+      double r = _uniform(chunk);
+      int row = 0, col = 0;
+
+      if (l < bits1 && l < bits2) {
+        row = (r > a + b);
+        col = (r > a && r <= a + b) || (r > a + b + c);
+      }
+      else if (l < bits1) {
+        row = (r > a + b);
+      }
+      else {
+        col = (r > a + c);
+      }
+
+      if (l < bits1) *x = (*x << 1) | row;
+      if (l < bits2) *y = (*y << 1) | col;
+    }
+  } while (*x >= gen->n1 || *y >= gen->n2);
+
+  *y += gen->n1;
+  chunk->unit++;
+  return 1;
+}
+
+//------------------------------------------------------------------- GRID
+
+static uint64_t _cellId(TGenerator *gen, uint64_t r, uint64_t c) {
+
+  // the cells of one colour in the order of rows
+  if (gen->cols % 2 == 0) {
+    return r * (gen->cols / 2) + c / 2;
+  }
+
+  return (r * gen->cols + c) / 2;
+}
+
+//-------------------------------------------------------------------
+
+static int _nextGrid(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  const int dr[] = {-1, 0, 0, 1};
+  const int dc[] = {0, -1, 1, 0};
+
+  // the neighbours of black cells are white
+  for (; chunk->unit < chunk->last; chunk->unit++, chunk->cell = chunk->unit % 2) {
+
+    uint64_t r = chunk->unit;
+
+    for (; chunk->cell < gen->cols; chunk->cell += 2, chunk->sub = 0) {
+
+      uint64_t c = chunk->cell;
+
+      while (chunk->sub < 4) {
+
+        int d = (int) chunk->sub++;
+
+        if ((r == 0 && dr[d] < 0) || (r + 1 == gen->rows && dr[d] > 0)
+            || (c == 0 && dc[d] < 0) || (c + 1 == gen->cols && dc[d] > 0)) continue;
+
+        if (gen->family == ROAD && _uniform(chunk) > gen->p) continue;
+
+        *x = _cellId(gen, r, c);
+        *y = gen->n1 + _cellId(gen, r + dr[d], c + dc[d]);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------- CHAINS
+
+static int _chainEdge(TGenerator *gen, uint64_t base, uint64_t k, uint64_t t, int edge, uint64_t *x, uint64_t *y) {
+
+  // x_t y_t in the perfect matching, y_t x_t+1 in the mates
+  if (edge == 0) {
+    *x = base + t;
+    *y = gen->n1 + base + t;
+    return 1;
+  }
+
+  if (t + 1 < k) {
+    *x = base + t + 1;
+    *y = gen->n1 + base + t;
+    return 1;
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int _nextChain(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  // units are the pairs of one chain
+  for (; chunk->unit < chunk->last; chunk->unit++, chunk->sub = 0) {
+    while (chunk->sub < 2) {
+      if (_chainEdge(gen, 0, gen->rows, chunk->unit, (int) chunk->sub++, x, y)) return 1;
+    }
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int _nextHK(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  // units are the chains of 1 .. K pairs
+  for (; chunk->unit < chunk->last; chunk->unit++, chunk->cell = 0) {
+
+    uint64_t k = chunk->unit + 1;
+    uint64_t base = chunk->unit * (chunk->unit + 1) / 2;
+
+    for (; chunk->cell < k; chunk->cell++, chunk->sub = 0) {
+      while (chunk->sub < 2) {
+        if (_chainEdge(gen, base, k, chunk->cell, (int) chunk->sub++, x, y)) return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------- CONFLICT
+
+static int _nextConflict(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  for (; chunk->unit < chunk->last; chunk->unit++, chunk->cell = 0) {
+
+    if (chunk->cell < gen->n2) {
+      *x = chunk->unit;
+      *y = gen->n1 + chunk->cell++;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------- EDGES
+
+int nextPair(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y) {
+
+  switch (gen->family) {
+    case ER:       return _nextER(gen, chunk, x, y);
+    case CHUNGLU:
+    case POWERLAW: return _nextChungLu(gen, chunk, x, y);
+    case RMAT:     return _nextRMAT(gen, chunk, x, y);
+    case GRID:
+    case ROAD:     return _nextGrid(gen, chunk, x, y);
+    case CHAIN:    return _nextChain(gen, chunk, x, y);
+    case HK:       return _nextHK(gen, chunk, x, y);
+    case TREES: return _nextConflict(gen, chunk, x, y);
+    default:       return 0;
+  }
+}
+
+//------------------------------------------------------------------- MATES
+
+int writeMates(TGenerator *gen, FILE *f) {
+
+  uint64_t x, y;
+
+  // the matching of the chains without their first and last nodes
+  if (gen->family == CHAIN) {
+    for (uint64_t t = 0; t + 1 < gen->rows; t++) {
+      _chainEdge(gen, 0, gen->rows, t, 1, &x, &y);
+      fprintf(f, "%" PRIu64 " %" PRIu64 "\n", x, y);
+    }
+  }
+  else if (gen->family == HK) {
+    for (uint64_t s = 0; s < gen->rows; s++) {
+      for (uint64_t t = 0; t < s; t++) {
+        _chainEdge(gen, s * (s + 1) / 2, s + 1, t, 1, &x, &y);
+        fprintf(f, "%" PRIu64 " %" PRIu64 "\n", x, y);
+      }
+    }
+  }
+  else {
+    return EPARAM;
+  }
+
+  return (fflush(f) == 0) ? EOK : EFILE;
+}
+
+/* end of file */
@@ -0,0 +1,398 @@
+/*
+ * Project: GAL 2014 - generator of bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Random and structured bipartite graphs in O(n + m). A family splits
+ * the graph into units (families.c), the units are split into chunks of
+ * about a million expected edges and every chunk has its own generator
+ * seeded by the seed and its index. The graph depends only on the
+ * parameters and the seed, not on the number of threads. The first pass
+ * counts the edges for the header, the second generates them again and
+ * the chunks are written in order.
+ *
+ * Usage: generator [FAMILY] PARAMS.. [--seed S] [--threads T] [--binary]
+ *                  [--mates FILE]
+ *
+ * Without a family the parameters are N1 N2 P of er. The text format is
+ * the input of the matching, the binary one has the header EGVB with 4
+ * or 8 byte ids. The families chain and hk write their bad matching to
+ * the file of --mates, the input of --init of the matching.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "generator.h"
+
+#define LINE_SIZE 48
+
+//------------------------------------------------------------------- FORMAT
+
+static char *_formatId(char *next, uint64_t value) {
+
+  char digits[24];
+  int count = 0;
+
+  do {
+    digits[count++] = '0' + (char) (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  while (count > 0) {
+    *next++ = digits[--count];
+  }
+
+  return next;
+}
+
+//-------------------------------------------------------------------
+
+static size_t _formatChunk(TGenerator *gen, uint64_t index, char *data) {
+
+  TChunk chunk;
+  uint64_t x, y;
+  char *next = data;
+
+  initChunk(gen, &chunk, index);
+
+  while (nextPair(gen, &chunk, &x, &y)) {
+
+    if (!gen->binary) {
+      next = _formatId(next, x);
+      *next++ = ' ';
+      next = _formatId(next, y);
+      *next++ = '\n';
+    }
+    else if (gen->width == sizeof(uint32_t)) {
+      uint32_t ids[2] = {(uint32_t) x, (uint32_t) y};
+      memcpy(next, ids, sizeof(ids));
+      next += sizeof(ids);
+    }
+    else {
+      uint64_t ids[2] = {x, y};
+      memcpy(next, ids, sizeof(ids));
+      next += sizeof(ids);
+    }
+  }
+
+  return next - data;
+}
+
+//------------------------------------------------------------------- THREADS
+
+static void *_runGenerator(void *params) {
+
+  TGenerator *gen = params;
+  char *data = NULL;
+  size_t size = 0;
+
+  while (1) {
+
+    // take the next chunk
+    pthread_mutex_lock(&(gen->mutex));
+    uint64_t index = gen->next++;
+    int stop = (index >= gen->nchunks || gen->error != EOK);
+    pthread_mutex_unlock(&(gen->mutex));
+
+    if (stop) {
+      break;
+    }
+
+    // the first pass counts the edges
+    if (gen->pass == 0) {
+
+      TChunk chunk;
+      uint64_t x, y, count = 0;
+
+      initChunk(gen, &chunk, index);
+      while (nextPair(gen, &chunk, &x, &y)) {
+        count++;
+      }
+
+      gen->counts[index] = count;
+      continue;
+    }
+
+    // the second pass formats them into the buffer of the thread
+    size_t needed = gen->counts[index] * (gen->binary ? 2 * gen->width : LINE_SIZE) + 1;
+
+    if (needed > size) {
+      free(data);
+      size = needed;
+      data = malloc(size);
+    }
+
+    size_t used = (data != NULL) ? _formatChunk(gen, index, data) : 0;
+
+    // and writes them in the order of chunks
+    pthread_mutex_lock(&(gen->mutex));
+
+    while (gen->written != index && gen->error == EOK) {
+      pthread_cond_wait(&(gen->turn), &(gen->mutex));
+    }
+
+    if (data == NULL) {
+      gen->error = EALLOC;
+    }
+    else if (gen->error == EOK && fwrite(data, 1, used, gen->f) != used) {
+      gen->error = EFILE;
+    }
+
+    gen->written++;
+    pthread_cond_broadcast(&(gen->turn));
+    pthread_mutex_unlock(&(gen->mutex));
+  }
+
+  free(data);
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _runPass(TGenerator *gen, int pass, int threads) {
+
+  TThread *ids = malloc(threads * sizeof(TThread));
+  if (ids == NULL) {
+    return EALLOC;
+  }
+
+  gen->pass = pass;
+  gen->next = 0;
+  gen->written = 0;
+
+  for (int i = 0; i < threads; i++) {
+    pthread_create(&ids[i], NULL, &_runGenerator, gen);
+  }
+
+  for (int i = 0; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+
+  free(ids);
+  return gen->error;
+}
+
+//------------------------------------------------------------------- GENERATE
+
+int generateGraph(TGenerator *gen, int threads) {
+
+  gen->counts = calloc(gen->nchunks + 1, sizeof(uint64_t));
+  gen->error = EOK;
+
+  if (gen->counts == NULL) {
+    return EALLOC;
+  }
+
+  pthread_mutex_init(&(gen->mutex), NULL);
+  pthread_cond_init(&(gen->turn), NULL);
+
+  int error = _runPass(gen, 0, threads);
+  uint64_t n = gen->n1 + gen->n2, m = 0;
+
+  for (uint64_t i = 0; i < gen->nchunks; i++) {
+    m += gen->counts[i];
+  }
+
+  // the header
+  if (error == EOK && gen->binary) {
+
+    TBinaryHeader header;
+    memcpy(header.magic, BINARY_MAGIC, 4);
+    header.width = gen->width;
+    header.n = n;
+    header.m = m;
+
+    if (fwrite(&header, sizeof(header), 1, gen->f) != 1) {
+      error = EFILE;
+    }
+  }
+  else if (error == EOK) {
+    fprintf(gen->f, "%" PRIu64 "\n%" PRIu64 "\n", n, m);
+  }
+
+  if (error == EOK) {
+    error = _runPass(gen, 1, threads);
+  }
+
+  if (error == EOK && fflush(gen->f) != 0) {
+    error = EFILE;
+  }
+
+  pthread_cond_destroy(&(gen->turn));
+  pthread_mutex_destroy(&(gen->mutex));
+  free(gen->counts);
+  return error;
+}
+
+//------------------------------------------------------------------- PARAMS
+
+typedef struct {
+  const char *name;
+  int family;
+  int required;
+  int optional;
+} TFamilyName;
+
+static const TFamilyName _families[] = {
+  {"er", ER, 3, 0},
+  {"chunglu", CHUNGLU, 3, 1},
+  {"powerlaw", POWERLAW, 3, 1},
+  {"rmat", RMAT, 3, 0},
+  {"grid", GRID, 2, 0},
+  {"road", ROAD, 2, 1},
+  {"chain", CHAIN, 1, 0},
+  {"hk", HK, 1, 0},
+  {"conflict", TREES, 2, 0}
+};
+
+//-------------------------------------------------------------------
+
+static int _setParams(TGenerator *gen, double *params, int count) {
+
+  const TFamilyName *name = NULL;
+
+  for (size_t i = 0; i < sizeof(_families) / sizeof(_families[0]); i++) {
+    if (_families[i].family == gen->family) name = &_families[i];
+  }
+
+  if (name == NULL || count < name->required || count > name->required + name->optional) {
+    return EPARAM;
+  }
+
+  // no negative params
+  for (int i = 0; i < count; i++) {
+    if (params[i] < 0) return EPARAM;
+  }
+
+  gen->gamma = (count > 3) ? params[3] : 2.5;
+  gen->p = (count > 2) ? params[2] : 0.6;
+
+  switch (gen->family) {
+    case ER:
+    case CHUNGLU:
+    case POWERLAW:
+    case RMAT:
+      gen->n1 = (uint64_t) params[0];
+      gen->n2 = (uint64_t) params[1];
+      gen->degree = params[2];
+      gen->edges = (uint64_t) params[2];
+      break;
+    case GRID:
+    case ROAD:
+      gen->rows = (uint64_t) params[0];
+      gen->cols = (uint64_t) params[1];
+      break;
+    case CHAIN:
+    case HK:
+      gen->rows = (uint64_t) params[0];
+      break;
+    case TREES:
+      gen->n1 = (uint64_t) params[0];
+      gen->cols = (uint64_t) params[1];
+      break;
+  }
+
+  return initFamily(gen);
+}
+
+//------------------------------------------------------------------- MAIN
+
+int main(int argc, char *argv[])
+{
+  int error = EOK;
+
+  TGenerator gen;
+  memset(&gen, 0, sizeof(TGenerator));
+
+  int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+  double params[4];
+  int count = 0, i = 1;
+  char *mates = NULL;
+
+  gen.f = stdout;
+
+  // the family, er by default
+  if (argc > 1 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+
+    gen.family = -1;
+
+    for (size_t j = 0; j < sizeof(_families) / sizeof(_families[0]); j++) {
+      if (strcmp(argv[1], _families[j].name) == 0) gen.family = _families[j].family;
+    }
+
+    i++;
+  }
+
+  // its params
+  for (; i < argc && strncmp(argv[i], "--", 2) != 0 && error == EOK; i++) {
+
+    char *end;
+
+    if (count < 4) {
+      params[count++] = strtod(argv[i], &end);
+      if (*end != '\0') error = EPARAM;
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+
+  // check options
+  for (; i < argc && error == EOK; i++) {
+
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      gen.seed = strtoull(argv[++i], NULL, 10);
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      if (threads <= 0) error = EPARAM;
+    }
+    else if (strcmp(argv[i], "--binary") == 0) {
+      gen.binary = 1;
+    }
+    else if (strcmp(argv[i], "--mates") == 0 && i + 1 < argc) {
+      mates = argv[++i];
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+
+  if (error == EOK) {
+    error = _setParams(&gen, params, count);
+  }
+
+  // the initial matching
+  if (error == EOK && mates != NULL) {
+
+    FILE *f = fopen(mates, "w");
+    if (f == NULL) {
+      error = EFILE;
+    }
+    else {
+      error = writeMates(&gen, f);
+      fclose(f);
+    }
+  }
+
+  // ids fit into 32 bits for most graphs
+  gen.width = (gen.n1 + gen.n2 <= UINT32_MAX) ? sizeof(uint32_t) : sizeof(uint64_t);
+
+  if (error == EOK) {
+    static char buffer[1 << 20];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    error = generateGraph(&gen, (threads > 0) ? threads : 1);
+  }
+
+  if (error != EOK) {
+    fprintf(stderr, "ERROR %d\n", error);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/* end of file */
@@ -0,0 +1,99 @@
+/*
+ * Project: GAL 2014 - generator of bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Families of bipartite graphs. A family splits its graph into units,
+ * rows of the first side, rows of a grid, chains or blocks of edges, and
+ * a chunk of units yields its edges from its own random generator.
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "../lib/internal.h"
+
+#define CHUNK_EDGES (1 << 20)
+
+//------------------------------------------------------------------- FAMILIES
+
+enum families {
+  ER = 0,
+  CHUNGLU,
+  POWERLAW,
+  RMAT,
+  GRID,
+  ROAD,
+  CHAIN,
+  HK,
+  TREES
+};
+
+//------------------------------------------------------------------- TYPES
+
+typedef struct tGenerator TGenerator;
+typedef struct tChunk TChunk;
+
+struct tGenerator {
+  int family;
+  uint64_t n1;
+  uint64_t n2;
+  uint64_t seed;
+  int binary;
+  uint32_t width;
+
+  // parameters of the families
+  double p;
+  double degree;
+  double gamma;
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t edges;
+
+  // power law weights w(k) = scale * (k + 1) ^ -alpha
+  double alpha;
+  double scale1;
+  double scale2;
+  double total;
+
+  // units of the graph and of a chunk
+  uint64_t units;
+  uint64_t perChunk;
+  uint64_t nchunks;
+  uint64_t *counts;
+
+  // the next chunk to generate and to write
+  uint64_t next;
+  uint64_t written;
+  int pass;
+  int error;
+
+  TMutex mutex;
+  TCond turn;
+  FILE *f;
+};
+
+struct tChunk {
+  uint64_t state;
+  uint64_t unit;
+  uint64_t last;
+
+  // position inside the unit
+  uint64_t cell;
+  uint64_t cells;
+  uint64_t sub;
+  double p;
+  double skip;
+};
+
+//------------------------------------------------------------------- FUNCTIONS
+
+int initFamily(TGenerator *gen);
+void initChunk(TGenerator *gen, TChunk *chunk, uint64_t index);
+int nextPair(TGenerator *gen, TChunk *chunk, uint64_t *x, uint64_t *y);
+int writeMates(TGenerator *gen, FILE *f);
+
+#endif
+
+/* end of file */
@@ -0,0 +1,211 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Benchmark of the phases of a run inside one process. The graph is
+ * loaded once, then every trial clears the matching, prepares the roots,
+ * searches and formats the matching into /dev/null. The first trial
+ * warms the caches and the allocator and is not counted. The report is
+ * a CSV row per phase with the median, minimum and standard deviation.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "internal.h"
+
+static const char *_stageNames[] = {"load", "match", "output", "prepare"};
+static const int _stageOrder[] = {LOAD, PREPARE, MATCH, OUTPUT};
+
+//------------------------------------------------------------------- SAMPLES
+
+int initBench(TBench *bench, int trials) {
+
+  memset(bench, 0, sizeof(TBench));
+  bench->trials = trials;
+  bench->M = -1;
+  bench->stable = 1;
+
+  for (int s = 0; s < BENCH_STAGES; s++) {
+
+    bench->samples[s] = malloc((size_t) trials * sizeof(uint64_t) + 1);
+    if (bench->samples[s] == NULL) {
+      return EALLOC;
+    }
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+void addSample(TBench *bench, int stage, uint64_t time) {
+
+  // the samples of a failed init are missing
+  if (bench->samples[stage] != NULL && bench->count[stage] < bench->trials) {
+    bench->samples[stage][bench->count[stage]++] = time;
+  }
+}
+
+//-------------------------------------------------------------------
+
+void freeBench(TBench *bench) {
+
+  for (int s = 0; s < BENCH_STAGES; s++) {
+    free(bench->samples[s]);
+    bench->samples[s] = NULL;
+  }
+}
+
+//------------------------------------------------------------------- TRIALS
+
+void clearMatching(TGraph *graph) {
+
+  // edges of added nodes are not in the array, go by the lists
+  for (TIndex i = 0; i < graph->n; i++) {
+    for (TEdge *edge = graph->nodes[i].edges; edge != NULL; edge = edge->next) {
+      edge->M = 0;
+    }
+  }
+
+  resetSearch(graph);
+}
+
+//-------------------------------------------------------------------
+
+static TIndex _countMatched(TGraph *graph) {
+
+  TIndex M = 0;
+
+  for (TIndex i = 0; i < graph->n; i++) {
+    M += inM(&(graph->nodes[i]));
+  }
+
+  return M / 2;
+}
+
+//-------------------------------------------------------------------
+
+int benchMatching(TPool *pool, TGraph *graph, TBench *bench) {
+
+  FILE *null = fopen("/dev/null", "w");
+  if (null == NULL) {
+    return EFILE;
+  }
+
+  int error = EOK;
+
+  // the trial 0 only warms up
+  for (int t = 0; t <= bench->trials && error == EOK; t++) {
+
+    TQueue Q;
+    uint64_t start = traceClock();
+
+    clearMatching(graph);
+    if (pool != NULL) {
+      error = initRoots(graph, &Q);
+    }
+
+    uint64_t prepared = traceClock();
+
+    if (error == EOK && pool != NULL) {
+      error = runRoots(pool, graph, &Q, NULL);
+      freeQueue(&Q);
+    }
+    else if (error == EOK) {
+      error = findMatchingSequence(graph);
+    }
+
+    uint64_t matched = traceClock();
+
+    if (error == EOK) {
+      error = writeMatching(pool, graph, TEXT, null);
+    }
+
+    uint64_t written = traceClock();
+
+    if (error != EOK || t == 0) continue;
+
+    addSample(bench, PREPARE, prepared - start);
+    addSample(bench, MATCH, matched - prepared);
+    addSample(bench, OUTPUT, written - matched);
+
+    // every trial must find a matching of the same size
+    TIndex M = _countMatched(graph);
+    if (bench->M >= 0 && M != bench->M) {
+      bench->stable = 0;
+    }
+
+    bench->M = M;
+  }
+
+  fclose(null);
+  return error;
+}
+
+//------------------------------------------------------------------- PRINT
+
+static int _compareTime(const void *a, const void *b) {
+
+  uint64_t x = *(const uint64_t *) a;
+  uint64_t y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+//-------------------------------------------------------------------
+
+double medianBench(TBench *bench, int stage) {
+
+  int count = bench->count[stage];
+  uint64_t *samples = bench->samples[stage];
+
+  if (count == 0) {
+    return 0;
+  }
+
+  // the samples stay sorted
+  qsort(samples, count, sizeof(uint64_t), &_compareTime);
+
+  return (count % 2) ? samples[count / 2]
+                     : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+}
+
+//-------------------------------------------------------------------
+
+void printBench(TBench *bench, const char *engine, const char *name, int threads, FILE *f) {
+
+  fprintf(f, "engine,graph,threads,M,stable,phase,samples,median_ms,min_ms,stddev_ms\n");
+
+  for (int i = 0; i < BENCH_STAGES; i++) {
+
+    int s = _stageOrder[i];
+    int count = bench->count[s];
+    uint64_t *samples = bench->samples[s];
+
+    if (count == 0) continue;
+
+    double median = medianBench(bench, s);
+    double mean = 0, deviation = 0;
+
+    for (int j = 0; j < count; j++) {
+      mean += samples[j];
+    }
+
+    mean /= count;
+
+    // corrected sample deviation
+    for (int j = 0; j < count; j++) {
+      deviation += (samples[j] - mean) * (samples[j] - mean);
+    }
+
+    deviation = (count > 1) ? sqrt(deviation / (count - 1)) : 0;
+
+    fprintf(f, "%s,%s,%d,%" PRIINDEX ",%d,%s,%d,%.3f,%.3f,%.3f\n",
+            engine, name, threads, bench->M, bench->stable, _stageNames[s], count,
+            median / 1e6, samples[0] / 1e6, deviation / 1e6);
+  }
+}
+
+/* end of file */
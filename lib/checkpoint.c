@@ -0,0 +1,239 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Checkpoints of a long matching. The workers stop taking new roots at
+ * a deadline, so no tree is in process when a snapshot is written. The
+ * snapshot keeps the mates of nodes, the finished roots and the nodes
+ * of APS trees, a resumed run searches only from the other roots.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+
+#include "internal.h"
+
+#define FINISHED 1
+#define INAPS    2
+
+//------------------------------------------------------------------- SAVE
+
+static int _writeSnapshot(TGraph *graph, TQueue *Q, FILE *f) {
+
+  TIndex *mates = malloc((size_t) graph->n * sizeof(TIndex));
+  uint8_t *flags = malloc((size_t) graph->n * sizeof(uint8_t));
+
+  if (graph->n > 0 && (mates == NULL || flags == NULL)) {
+    free(mates);
+    free(flags);
+    return EALLOC;
+  }
+
+  // roots in the queue are not finished yet
+  for (TIndex i = 0; i < graph->n; i++) {
+    flags[i] = FINISHED;
+  }
+
+  for (TItem *item = Q->first; item != NULL; item = item->next) {
+    flags[((TNode*) item->item)->id] &= ~FINISHED;
+  }
+
+  // mates and APS trees
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    TNode *node = &(graph->nodes[i]);
+    TEdge *edge = node->edges;
+
+    while((edge != NULL) && !(edge->M)) {
+      edge = edge->next;
+    }
+
+    mates[i] = (edge != NULL) ? edge->node->id : -1;
+
+    if (node->colour == GREEN) {
+      flags[i] |= INAPS;
+    }
+  }
+
+  // write the snapshot
+  TBinaryHeader header;
+  memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+  header.width = sizeof(TIndex);
+  header.n = graph->n;
+  header.m = graph->m;
+
+  int error = EOK;
+
+  if (fwrite(&header, sizeof(header), 1, f) != 1
+     || fwrite(mates, sizeof(TIndex), graph->n, f) != (size_t) graph->n
+     || fwrite(flags, sizeof(uint8_t), graph->n, f) != (size_t) graph->n) {
+    error = EFILE;
+  }
+
+  free(mates);
+  free(flags);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int saveSnapshot(TGraph *graph, TQueue *Q, const char *fname) {
+
+  // write a new file and replace the old snapshot at once
+  char *tmp = malloc(strlen(fname) + 5);
+  if (tmp == NULL) {
+    return EALLOC;
+  }
+
+  sprintf(tmp, "%s.tmp", fname);
+
+  FILE *f = fopen(tmp, "wb");
+  if (f == NULL) {
+    free(tmp);
+    return EFILE;
+  }
+
+  int error = _writeSnapshot(graph, Q, f);
+
+  if (fclose(f) != 0 && error == EOK) {
+    error = EFILE;
+  }
+
+  if (error == EOK && rename(tmp, fname) != 0) {
+    error = EFILE;
+  }
+
+  if (error != EOK) {
+    remove(tmp);
+  }
+
+  free(tmp);
+  return error;
+}
+
+//------------------------------------------------------------------- LOAD
+
+static int _readSnapshot(TGraph *graph, TQueue *Q, FILE *f, TIndex *mates, uint8_t *flags) {
+
+  // check the snapshot belongs to the graph
+  TBinaryHeader header;
+
+  if (fread(&header, sizeof(header), 1, f) != 1
+     || memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0
+     || header.width != sizeof(TIndex)
+     || header.n != (uint64_t) graph->n || header.m != (uint64_t) graph->m) {
+    return EINPUT;
+  }
+
+  if (fread(mates, sizeof(TIndex), graph->n, f) != (size_t) graph->n
+     || fread(flags, sizeof(uint8_t), graph->n, f) != (size_t) graph->n) {
+    return EINPUT;
+  }
+
+  // every node has at most one mate, which has it back
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    if (mates[i] != -1 && (mates[i] < 0 || mates[i] >= graph->n || mates[mates[i]] != i)) {
+      return EINPUT;
+    }
+  }
+
+  // restore the matching and APS trees
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    if (mates[i] > i && matchEdge(graph, i, mates[i]) != EOK) {
+      return EINPUT;
+    }
+
+    if (flags[i] & INAPS) {
+      graph->nodes[i].colour = GREEN;
+    }
+  }
+
+  // unfinished roots
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    if (!(flags[i] & FINISHED) && pushQueue(Q, &(graph->nodes[i])) != EOK) {
+      return EALLOC;
+    }
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int loadSnapshot(TGraph *graph, TQueue *Q, const char *fname) {
+
+  FILE *f = fopen(fname, "rb");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  TIndex *mates = malloc((size_t) graph->n * sizeof(TIndex));
+  uint8_t *flags = malloc((size_t) graph->n * sizeof(uint8_t));
+  int error = EALLOC;
+
+  initQueue(Q);
+  resetSearch(graph);
+
+  if (graph->n == 0 || (mates != NULL && flags != NULL)) {
+    error = _readSnapshot(graph, Q, f, mates, flags);
+  }
+
+  if (error != EOK) {
+    freeQueue(Q);
+  }
+
+  free(mates);
+  free(flags);
+  fclose(f);
+  return error;
+}
+
+//------------------------------------------------------------------- FIND MATCHING
+
+int findMatchingCheckpoint(TPool *pool, TGraph *graph, const char *fname, int interval, int resume) {
+
+  TQueue Q;
+  int error = EOK;
+
+  // start from the snapshot or from all nodes
+  if (resume) {
+    error = loadSnapshot(graph, &Q, fname);
+  }
+  else {
+    resetSearch(graph);
+    error = initRoots(graph, &Q);
+  }
+
+  if (error != EOK) {
+    return error;
+  }
+
+  // save a snapshot after each interval and at the end
+  while (error == EOK) {
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += interval;
+
+    TLimits limits = {(interval > 0) ? &deadline : NULL, 0, 0};
+    error = runRoots(pool, graph, &Q, &limits);
+    if (error == EOK) {
+      error = saveSnapshot(graph, &Q, fname);
+    }
+
+    if (isEmptyQueue(&Q)) {
+      break;
+    }
+  }
+
+  freeQueue(&Q);
+  return error;
+}
+
+/* end of file */
@@ -0,0 +1,534 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Compressed adjacency for graphs that do not fit into memory as lists
+ * of edges. Neighbour lists are sorted and the gaps between neighbours
+ * are stored as varints, the matching is kept in an array of mates, so
+ * the lists are only read.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- READ EDGES
+
+static int _readEdges(FILE *f, TIndex *n, TIndex *m, TIndex **edges) {
+
+  TReader *reader = malloc(sizeof(TReader));
+  if (reader == NULL) {
+    return EALLOC;
+  }
+
+  int error = openReader(reader, f);
+
+  if (error == EOK) {
+    *n = reader->n;
+    *edges = malloc(2 * (size_t) reader->m * sizeof(TIndex) + 1);
+    error = (*edges != NULL) ? EOK : EALLOC;
+  }
+
+  // skip edges that addEdge would refuse
+  TIndex x, y;
+
+  while (error == EOK && nextEdge(reader, &x, &y)) {
+
+    if (x != y && x >= 0 && y >= 0 && x < *n && y < *n) {
+      (*edges)[2 * (size_t) (*m)] = x;
+      (*edges)[2 * (size_t) (*m) + 1] = y;
+      (*m)++;
+    }
+  }
+
+  if (error == EOK) {
+    error = reader->error;
+  }
+
+  free(reader);
+  return error;
+}
+
+//------------------------------------------------------------------- ENCODE
+
+static int _compareIds(const void *a, const void *b) {
+
+  TIndex x = *((const TIndex*) a);
+  TIndex y = *((const TIndex*) b);
+  return (x > y) - (x < y);
+}
+
+//-------------------------------------------------------------------
+
+uint64_t sortList(TIndex *list, size_t count) {
+
+  qsort(list, count, sizeof(TIndex), _compareIds);
+
+  // count the bytes of gaps
+  uint64_t size = 0;
+  TIndex last = 0;
+
+  for (size_t i = 0; i < count; i++) {
+
+    uint64_t gap = (uint64_t) (list[i] - last);
+    last = list[i];
+
+    do {
+      gap >>= 7;
+      size++;
+    } while (gap > 0);
+  }
+
+  return size;
+}
+
+//-------------------------------------------------------------------
+
+uint8_t *encodeList(uint8_t *bytes, const TIndex *list, size_t count) {
+
+  TIndex last = 0;
+
+  for (size_t i = 0; i < count; i++) {
+
+    uint64_t gap = (uint64_t) (list[i] - last);
+    last = list[i];
+
+    while (gap >= 0x80) {
+      *bytes++ = (uint8_t) (gap | 0x80);
+      gap >>= 7;
+    }
+
+    *bytes++ = (uint8_t) gap;
+  }
+
+  return bytes;
+}
+
+//-------------------------------------------------------------------
+
+static int _encodeGraph(TCompressed *graph, uint64_t *offsets, TIndex **edges) {
+
+  TIndex n = graph->n;
+
+  // count degrees and turn them into starts of neighbour lists
+  memset(offsets, 0, ((size_t) n + 1) * sizeof(uint64_t));
+
+  for (size_t i = 0; i < 2 * (size_t) graph->m; i++) {
+    offsets[(*edges)[i] + 1]++;
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  TIndex *lists = malloc(2 * (size_t) graph->m * sizeof(TIndex) + 1);
+  if (lists == NULL) {
+    return EALLOC;
+  }
+
+  // fill the lists, each start moves to the start of the next list
+  for (TIndex i = 0; i < graph->m; i++) {
+
+    TIndex x = (*edges)[2 * (size_t) i];
+    TIndex y = (*edges)[2 * (size_t) i + 1];
+    lists[offsets[x]++] = y;
+    lists[offsets[y]++] = x;
+  }
+
+  memmove(offsets + 1, offsets, (size_t) n * sizeof(uint64_t));
+  offsets[0] = 0;
+
+  free(*edges);
+  *edges = NULL;
+
+  // sort the lists and count the bytes of gaps
+  size_t size = 0;
+
+  for (TIndex i = 0; i < n; i++) {
+    size += sortList(lists + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  uint8_t *encoded = malloc(size + 1);
+  if (encoded == NULL) {
+    free(lists);
+    return EALLOC;
+  }
+
+  graph->bytes = encoded;
+  graph->size = size;
+
+  // encode the lists, offsets change from ids to bytes
+  uint8_t *bytes = encoded;
+  size_t start = 0;
+
+  for (TIndex i = 0; i < n; i++) {
+
+    size_t end = offsets[i + 1];
+
+    offsets[i] = bytes - encoded;
+    bytes = encodeList(bytes, lists + start, end - start);
+    start = end;
+  }
+
+  offsets[n] = size;
+
+  free(lists);
+  return EOK;
+}
+
+//------------------------------------------------------------------- LOAD
+
+int loadCompressed(TCompressed *graph, FILE *f) {
+
+  initCompressed(graph);
+
+  // read edges as pairs of ids
+  TIndex *edges = NULL;
+  int error = _readEdges(f, &(graph->n), &(graph->m), &edges);
+
+  uint64_t *offsets = NULL;
+
+  if (error == EOK) {
+    offsets = malloc(((size_t) graph->n + 1) * sizeof(uint64_t));
+    graph->offsets = offsets;
+    graph->mates = malloc((size_t) graph->n * sizeof(TIndex) + 1);
+
+    error = (offsets != NULL && graph->mates != NULL) ? EOK : EALLOC;
+  }
+
+  if (error == EOK) {
+    error = _encodeGraph(graph, offsets, &edges);
+  }
+
+  if (error == EOK) {
+    for (TIndex i = 0; i < graph->n; i++) {
+      graph->mates[i] = -1;
+    }
+  }
+
+  free(edges);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void initCompressed(TCompressed *graph) {
+
+  graph->n = 0;
+  graph->m = 0;
+  graph->ntree = 0;
+  graph->offsets = NULL;
+  graph->bytes = NULL;
+  graph->size = 0;
+  graph->mates = NULL;
+  graph->map = NULL;
+  graph->mapSize = 0;
+
+  memset(graph->phases, 0, sizeof(graph->phases));
+}
+
+//-------------------------------------------------------------------
+
+void freeCompressed(TCompressed *graph) {
+
+  // mapped lists belong to the file
+  if (graph->map != NULL) {
+    munmap(graph->map, graph->mapSize);
+  }
+  else {
+    free((void*) graph->offsets);
+    free((void*) graph->bytes);
+  }
+
+  free(graph->mates);
+
+  graph->offsets = NULL;
+  graph->bytes = NULL;
+  graph->mates = NULL;
+  graph->map = NULL;
+}
+
+//------------------------------------------------------------------- APPLY APS
+
+static void _processPath(TIndex *mates, TIndex *parents, TIndex root, TIndex end) {
+
+  TIndex y = end;
+
+  // flip the path from the free end to the root
+  while (1) {
+
+    TIndex x = parents[y];
+    TIndex next = mates[x];
+
+    mates[x] = y;
+    mates[y] = x;
+
+    if (x == root) break;
+    y = next;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static void _applyAPS(TCompressed *graph, TIndex root, TIndex *trees, TIndex *parents,
+                      TIndex *queue, uint8_t *aps) {
+
+  TIndex *mates = graph->mates;
+  uint64_t *bytes = &(graph->phases[SEARCH].bytes);
+  TIndex first = 0, last = 0;
+
+  trees[root] = root;
+  queue[last++] = root;
+
+  while (first < last) {
+
+    // get x and walk its neighbours
+    TIndex x = queue[first++];
+    TIndex y;
+    TCursor cursor;
+
+    initCursor(&cursor, graph, x);
+    const uint8_t *begin = cursor.next;
+
+    while (nextNeighbour(&cursor, &y)) {
+
+      if (trees[y] == root || (trees[y] >= 0 && aps[trees[y]])) {
+        continue;
+      }
+
+      trees[y] = root;
+      parents[y] = x;
+
+      // y is not in M, we found a path
+      if (mates[y] < 0) {
+        *bytes += cursor.next - begin;
+        _processPath(mates, parents, root, y);
+        return;
+      }
+
+      // add the mate of y to Q
+      TIndex z = mates[y];
+      trees[z] = root;
+      queue[last++] = z;
+    }
+
+    *bytes += cursor.next - begin;
+  }
+
+  // we found APS-tree
+  aps[root] = 1;
+}
+
+//------------------------------------------------------------------- GREEDY
+
+static void _matchGreedy(TCompressed *graph) {
+
+  TIndex *mates = graph->mates;
+  uint64_t *bytes = &(graph->phases[GREEDY].bytes);
+
+  // match each free node with its first free neighbour
+  for (TIndex x = 0; x < graph->n; x++) {
+
+    TIndex y;
+    TCursor cursor;
+
+    initCursor(&cursor, graph, x);
+    const uint8_t *begin = cursor.next;
+
+    while (mates[x] < 0 && nextNeighbour(&cursor, &y)) {
+
+      if (mates[y] < 0) {
+        mates[x] = y;
+        mates[y] = x;
+      }
+    }
+
+    *bytes += cursor.next - begin;
+  }
+}
+
+//------------------------------------------------------------------- PHASES
+
+static double _seconds(void) {
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static long _faults(void) {
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_majflt;
+}
+
+//-------------------------------------------------------------------
+
+void beginPhase(TPhase *phase) {
+
+  phase->bytes = 0;
+  phase->time = _seconds();
+  phase->faults = _faults();
+}
+
+void endPhase(TPhase *phase) {
+
+  phase->time = _seconds() - phase->time;
+  phase->faults = _faults() - phase->faults;
+}
+
+//-------------------------------------------------------------------
+
+static void _adviseMap(TCompressed *graph, int advice) {
+
+  if (graph->map != NULL) {
+    madvise(graph->map, graph->mapSize, advice);
+  }
+}
+
+//------------------------------------------------------------------- FIND MATCHING
+
+int findMatchingCompressed(TCompressed *graph) {
+
+  TIndex n = graph->n;
+  TIndex *trees = malloc((size_t) n * sizeof(TIndex) + 1);
+  TIndex *parents = malloc((size_t) n * sizeof(TIndex) + 1);
+  TIndex *queue = malloc((size_t) n * sizeof(TIndex) + 1);
+  uint8_t *aps = calloc((size_t) n + 1, sizeof(uint8_t));
+
+  int error = EALLOC;
+
+  if (trees != NULL && parents != NULL && queue != NULL && aps != NULL) {
+
+    for (TIndex i = 0; i < n; i++) {
+      trees[i] = -1;
+    }
+
+    // one sequential pass over the lists matches most nodes
+    _adviseMap(graph, MADV_SEQUENTIAL);
+    beginPhase(&(graph->phases[GREEDY]));
+    _matchGreedy(graph);
+    endPhase(&(graph->phases[GREEDY]));
+
+    // search from every free node, trees read the lists in any order
+    _adviseMap(graph, MADV_NORMAL);
+    beginPhase(&(graph->phases[SEARCH]));
+    graph->ntree = 0;
+
+    for (TIndex i = 0; i < n; i++) {
+
+      if (graph->mates[i] >= 0) continue;
+
+      graph->ntree++;
+      _applyAPS(graph, i, trees, parents, queue, aps);
+    }
+
+    endPhase(&(graph->phases[SEARCH]));
+
+    error = EOK;
+  }
+
+  free(trees);
+  free(parents);
+  free(queue);
+  free(aps);
+  return error;
+}
+
+//------------------------------------------------------------------- PRINT
+
+static void _printCompression(TCompressed *graph, FILE *f) {
+
+  // decode all lists once
+  double seconds = _seconds();
+
+  volatile TIndex sum = 0;
+  TIndex id;
+  TCursor cursor;
+
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    initCursor(&cursor, graph, i);
+    while (nextNeighbour(&cursor, &id)) {
+      sum ^= id;
+    }
+  }
+
+  seconds = _seconds() - seconds;
+
+  // compare with lists of edges and with pairs of ids
+  double lists = 2.0 * graph->m * sizeof(TEdge);
+  double pairs = 2.0 * graph->m * sizeof(TIndex);
+  double size = (graph->size > 0) ? graph->size : 1;
+  double rate = (seconds > 0) ? 1 / seconds : 0;
+
+  fprintf(f, "<Compression>\nbytes %" PRIu64 "\nratio %.2f\nratio-ids %.2f\n"
+             "decode %.1f Medges/s %.1f MB/s\n\n",
+          graph->size, lists / size, pairs / size,
+          2.0 * graph->m * rate / 1e6, graph->size * rate / 1e6);
+}
+
+//-------------------------------------------------------------------
+
+static void _printPhase(const char *name, TPhase *phase, FILE *f) {
+
+  double rate = (phase->time > 0) ? phase->bytes / phase->time / 1e6 : 0;
+
+  fprintf(f, "%s %.1f MB %.3f s %.1f MB/s faults %ld\n",
+          name, phase->bytes / 1e6, phase->time, rate, phase->faults);
+}
+
+//-------------------------------------------------------------------
+
+static void _printIO(TCompressed *graph, FILE *f) {
+
+  fprintf(f, "<IO>\nfile %.1f MB\n", graph->mapSize / 1e6);
+  _printPhase("build", &(graph->phases[BUILD]), f);
+  _printPhase("greedy", &(graph->phases[GREEDY]), f);
+  _printPhase("search", &(graph->phases[SEARCH]), f);
+  fprintf(f, "\n");
+}
+
+//-------------------------------------------------------------------
+
+void printCompressed(TCompressed *graph, FILE *f) {
+
+  TIndex M = 0;
+  fprintf(f, "<Matching>\n");
+
+  // print edges in matching
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    if (i < graph->mates[i]) {
+      fprintf(f, "(%" PRIINDEX ",%" PRIINDEX ") ", i, graph->mates[i]);
+      M++;
+    }
+  }
+
+  if (M != 0) {
+    fprintf(f, "\n\n");
+  }
+
+  fprintf(f, "<Nodes>\n%" PRIINDEX "\n\n", graph->n);
+  fprintf(f, "<Edges>\n%" PRIINDEX "\n\n", graph->m);
+  fprintf(f, "<Trees>\n%" PRIINDEX "\n\n", graph->ntree);
+
+  // a mapped graph reports the reads of the file
+  if (graph->map != NULL) {
+    _printIO(graph, f);
+  }
+  else {
+    _printCompression(graph, f);
+  }
+
+  fprintf(f, "<M>\n%" PRIINDEX "\n", M);
+}
+
+/* end of file */
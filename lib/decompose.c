@@ -0,0 +1,351 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Dulmage-Mendelsohn decomposition of a graph with a maximum matching.
+ * The first side are rows and the second side columns. Nodes reachable
+ * by alternating paths from free columns form the horizontal part, from
+ * free rows the vertical part and the rest is the square part with a
+ * perfect matching. The fine blocks are the connected components of the
+ * horizontal and vertical parts and the strongly connected components of
+ * the square part, where a row leads to the rows matched to its columns.
+ * Blocks are numbered in the order of the block triangular form.
+ */
+
+#include <string.h>
+
+#include "internal.h"
+
+typedef struct tReach TReach;
+
+struct tReach {
+  TCertificate *cert;
+  int side;
+  uint8_t *reached;
+  TIndex *queue;
+};
+
+//------------------------------------------------------------------- COARSE
+
+static int _reachSide(TJob *job, TWorker *worker) {
+
+  (void) worker;
+
+  TReach *reach = job->data;
+  reachFree(job->graph, reach->cert, reach->side, reach->reached, reach->queue);
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static int _splitParts(TPool *pool, TGraph *graph, TCertificate *cert, TDecomposition *dm) {
+
+  TIndex n = graph->n;
+  TReach reach[2];
+  TJob jobs[2];
+  int error = EOK;
+
+  // both sides are searched at once
+  for (int i = 0; i < 2; i++) {
+
+    reach[i].cert = cert;
+    reach[i].side = i;
+    reach[i].reached = malloc((size_t) n + 1);
+    reach[i].queue = malloc((size_t) n * sizeof(TIndex) + 1);
+
+    if (reach[i].reached == NULL || reach[i].queue == NULL) {
+      error = EALLOC;
+    }
+
+    jobs[i].task = &_reachSide;
+    jobs[i].graph = graph;
+    jobs[i].data = &reach[i];
+    jobs[i].error = EOK;
+    jobs[i].done = 1;
+  }
+
+  for (int i = 0; i < 2 && error == EOK; i++) {
+
+    if (pool == NULL) {
+      jobs[i].error = _reachSide(&jobs[i], NULL);
+    }
+    else {
+      error = submitJob(pool, &jobs[i]);
+    }
+  }
+
+  if (pool != NULL) {
+    waitJobs(pool, jobs, 2);
+  }
+
+  // free columns reach the horizontal part, free rows the vertical one
+  if (error == EOK) {
+
+    for (TIndex i = 0; i < n; i++) {
+      dm->part[i] = reach[1].reached[i] ? HORIZONTAL : (reach[0].reached[i] ? VERTICAL : SQUARE);
+    }
+  }
+
+  for (int i = 0; i < 2; i++) {
+    free(reach[i].reached);
+    free(reach[i].queue);
+  }
+
+  return error;
+}
+
+//------------------------------------------------------------------- FINE
+
+static void _componentBlocks(TGraph *graph, TDecomposition *dm, int part, TIndex *queue) {
+
+  // connected components of the part
+  for (TIndex s = 0; s < graph->n; s++) {
+
+    if (dm->part[s] != part || dm->block[s] >= 0) continue;
+
+    TIndex first = 0, last = 0;
+    queue[last++] = s;
+    dm->block[s] = dm->nblocks;
+
+    while (first < last) {
+
+      TIndex x = queue[first++];
+
+      for (TEdge *edge = graph->nodes[x].edges; edge != NULL; edge = edge->next) {
+
+        TIndex y = edge->node->id;
+
+        if (dm->part[y] == part && dm->block[y] < 0) {
+          dm->block[y] = dm->nblocks;
+          queue[last++] = y;
+        }
+      }
+    }
+
+    dm->nblocks++;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int _squareBlocks(TGraph *graph, TCertificate *cert, TDecomposition *dm) {
+
+  TIndex n = graph->n;
+  TIndex *index = malloc((size_t) n * sizeof(TIndex) + 1);
+  TIndex *low = malloc((size_t) n * sizeof(TIndex) + 1);
+  TIndex *stack = malloc((size_t) n * sizeof(TIndex) + 1);
+  TIndex *calls = malloc((size_t) n * sizeof(TIndex) + 1);
+  TEdge **next = malloc((size_t) n * sizeof(TEdge*) + 1);
+
+  if (index == NULL || low == NULL || stack == NULL || calls == NULL || next == NULL) {
+    free(index); free(low); free(stack); free(calls); free(next);
+    return EALLOC;
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    index[i] = -1;
+  }
+
+  // Tarjan without recursion over the rows of the square part,
+  // a row leads to the mates of its columns
+  TIndex counter = 0, top = 0, depth = 0, found = 0;
+  TIndex base = dm->nblocks;
+
+  for (TIndex s = 0; s < n; s++) {
+
+    if (dm->part[s] != SQUARE || cert->side[s] != 0 || index[s] >= 0) continue;
+
+    index[s] = low[s] = counter++;
+    next[s] = graph->nodes[s].edges;
+    stack[top++] = s;
+    calls[depth++] = s;
+
+    while (depth > 0) {
+
+      TIndex x = calls[depth - 1];
+      TEdge *edge = next[x];
+
+      if (edge != NULL) {
+
+        next[x] = edge->next;
+        TIndex y = edge->node->id;
+
+        if (edge->M || dm->part[y] != SQUARE) continue;
+
+        TIndex r = cert->mates[y];
+
+        if (index[r] < 0) {
+          index[r] = low[r] = counter++;
+          next[r] = graph->nodes[r].edges;
+          stack[top++] = r;
+          calls[depth++] = r;
+        }
+        else if (dm->block[r] < 0 && index[r] < low[x]) {
+          low[x] = index[r];
+        }
+
+        continue;
+      }
+
+      // x is done, it may close a component
+      depth--;
+
+      if (low[x] == index[x]) {
+
+        TIndex r;
+        do {
+          r = stack[--top];
+          dm->block[r] = base + found;
+          dm->block[cert->mates[r]] = base + found;
+        } while (r != x);
+
+        found++;
+      }
+
+      if (depth > 0) {
+        TIndex p = calls[depth - 1];
+        if (low[x] < low[p]) low[p] = low[x];
+      }
+    }
+  }
+
+  // components come out in the reversed topological order
+  for (TIndex i = 0; i < n; i++) {
+    if (dm->part[i] == SQUARE) {
+      dm->block[i] = base + (found - 1 - (dm->block[i] - base));
+    }
+  }
+
+  dm->nblocks += found;
+
+  free(index); free(low); free(stack); free(calls); free(next);
+  return EOK;
+}
+
+//------------------------------------------------------------------- DECOMPOSE
+
+int decomposeMatching(TPool *pool, TGraph *graph, TCertificate *cert, TDecomposition *dm) {
+
+  TIndex n = graph->n;
+
+  dm->n = n;
+  dm->nblocks = 0;
+  dm->cover = cert->cover;
+  dm->part = malloc((size_t) n + 1);
+  dm->block = malloc((size_t) n * sizeof(TIndex) + 1);
+
+  if (dm->part == NULL || dm->block == NULL) {
+    return EALLOC;
+  }
+
+  // the blocks are defined only for a maximum matching
+  if (!cert->verified) {
+    return EINPUT;
+  }
+
+  int error = _splitParts(pool, graph, cert, dm);
+
+  for (TIndex i = 0; i < n; i++) {
+    dm->block[i] = -1;
+  }
+
+  // horizontal, square and vertical blocks
+  TIndex *queue = malloc((size_t) n * sizeof(TIndex) + 1);
+  if (error == EOK && queue == NULL) {
+    error = EALLOC;
+  }
+
+  if (error == EOK) {
+    _componentBlocks(graph, dm, HORIZONTAL, queue);
+    error = _squareBlocks(graph, cert, dm);
+  }
+
+  if (error == EOK) {
+    _componentBlocks(graph, dm, VERTICAL, queue);
+  }
+
+  free(queue);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void freeDecomposition(TDecomposition *dm) {
+
+  free(dm->part);
+  free(dm->block);
+}
+
+//------------------------------------------------------------------- PRINT
+
+static void _printNodes(TDecomposition *dm, const uint8_t *values, int value, FILE *f) {
+
+  for (TIndex i = 0; i < dm->n; i++) {
+    if (values[i] == value) {
+      fprintf(f, "%" PRIINDEX " ", i);
+    }
+  }
+
+  fprintf(f, "\n\n");
+}
+
+//-------------------------------------------------------------------
+
+int printDecomposition(TDecomposition *dm, FILE *f) {
+
+  // nodes ordered by blocks
+  TIndex *starts = calloc((size_t) dm->nblocks + 1, sizeof(TIndex));
+  TIndex *nodes = malloc((size_t) dm->n * sizeof(TIndex) + 1);
+
+  if (starts == NULL || nodes == NULL) {
+    free(starts);
+    free(nodes);
+    return EALLOC;
+  }
+
+  for (TIndex i = 0; i < dm->n; i++) {
+    starts[dm->block[i] + 1]++;
+  }
+
+  for (TIndex b = 0; b < dm->nblocks; b++) {
+    starts[b + 1] += starts[b];
+  }
+
+  for (TIndex i = 0; i < dm->n; i++) {
+    nodes[starts[dm->block[i]]++] = i;
+  }
+
+  fprintf(f, "<VertexCover>\n");
+  _printNodes(dm, dm->cover, 1, f);
+
+  fprintf(f, "<Horizontal>\n");
+  _printNodes(dm, dm->part, HORIZONTAL, f);
+
+  fprintf(f, "<Square>\n");
+  _printNodes(dm, dm->part, SQUARE, f);
+
+  fprintf(f, "<Vertical>\n");
+  _printNodes(dm, dm->part, VERTICAL, f);
+
+  // one block per line, the starts now point to the ends
+  fprintf(f, "<Blocks>\n");
+
+  for (TIndex b = 0, i = 0; b < dm->nblocks; b++) {
+
+    for (; i < starts[b]; i++) {
+      fprintf(f, "%" PRIINDEX " ", nodes[i]);
+    }
+
+    fprintf(f, "\n");
+  }
+
+  fprintf(f, "\n<NBlocks>\n%" PRIINDEX "\n", dm->nblocks);
+
+  free(starts);
+  free(nodes);
+  return EOK;
+}
+
+/* end of file */
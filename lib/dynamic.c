@@ -0,0 +1,556 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Dynamic matching. A batch of edge updates is applied to a graph with
+ * a maximum matching and the matching is repaired by searches started
+ * only from the endpoints of the updates:
+ *
+ *   - delete of a matched edge AB: search from A, if A is dead, from B
+ *   - insert of an edge AB with a free node: search from the free node
+ *   - insert of an edge AB between free nodes: add AB to M
+ *   - insert of an edge AB between matched nodes: unmatch AA', search
+ *     from A' without A and if it succeeds, search from A
+ *
+ * Each rule keeps the matching maximum if the updates come one by one.
+ * The updates are repaired in rounds in parallel. Every update owns the
+ * nodes its searches visit. A search that meets a node of another update
+ * gives up, its update is undone and repeated in the next round, so the
+ * result is the same as if the repaired updates came one by one.
+ *
+ * A dead search visits the whole alternating tree of its root, so when
+ * the searches of a batch visit more than n + m nodes, the rest of the
+ * batch is applied at once and the graph is matched in the pool.
+ */
+
+#include "internal.h"
+
+//------------------------------------------------------------------- SEARCH
+
+static int claimNode(TUpdate *update, TNode *node, TEdge *entry, int colour) {
+
+  int status = OK;
+  lockNode(node);
+
+  if (node->tree == NULL) {
+
+    // remember the node to release it after the round
+    if (update->count == update->size) {
+      int size = (update->size > 0) ? 2 * update->size : 64;
+      TNode **nodes = realloc(update->nodes, size * sizeof(TNode*));
+
+      if (nodes == NULL) {
+        unlockNode(node);
+        return ABORT;
+      }
+
+      update->nodes = nodes;
+      update->size = size;
+    }
+
+    update->nodes[update->count++] = node;
+    node->tree = &(update->tree);
+  }
+  else if (node->tree != &(update->tree)) {
+    status = CONFLICT;
+  }
+  else if (node->colour != WHITE) {
+    status = IGNORE;
+  }
+
+  if (status == OK) {
+    node->colour = colour;
+    node->entry = entry;
+  }
+
+  unlockNode(node);
+  return status;
+}
+
+//-------------------------------------------------------------------
+
+static void releaseNodes(TUpdate *update) {
+
+  for (TIndex i = 0; i < update->count; i++) {
+
+    TNode *node = update->nodes[i];
+    node->colour = WHITE;
+    node->entry = NULL;
+    node->tree = NULL;
+  }
+
+  update->count = 0;
+}
+
+//-------------------------------------------------------------------
+
+static TEdge *getM(TNode *node) {
+
+  TEdge *edge = node->edges;
+  while((edge != NULL) && !(edge->M)) {
+    edge = edge->next;
+  }
+
+  return edge;
+}
+
+//-------------------------------------------------------------------
+
+static int processPath(TNode *end, TList *path) {
+
+  // change M on the path and remember the edges for undo
+  TNode *node = end;
+
+  while (node->entry != NULL) {
+    TEdge *edge = node->entry->reversed;
+    changeM(edge);
+
+    if (pushList(path, edge) != EOK) {
+      return EALLOC;
+    }
+
+    node = edge->node;
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static void undoPath(TList *path) {
+
+  while(!isEmptyList(path)) {
+    changeM(popList(path));
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int search(TUpdate *update, TNode *root, TNode *blocked, TList *path, int *status) {
+
+  // forget the previous search of the update
+  for (TIndex i = 0; i < update->count; i++) {
+    update->nodes[i]->colour = WHITE;
+  }
+
+  int qsize = 64;
+  int first = 0;
+  int last = 0;
+
+  TNode **Q = malloc(qsize * sizeof(TNode*));
+  if (Q == NULL) {
+    return EALLOC;
+  }
+
+  int error = EOK;
+  *status = claimNode(update, root, NULL, RED);
+  Q[last++] = root;
+
+  // alternating search from the root
+  while (error == EOK && *status == OK && first < last) {
+
+    TNode *nodeA = Q[first++];
+
+    for (TEdge *AB = nodeA->edges; AB != NULL; AB = AB->next) {
+
+      TNode *nodeB = AB->node;
+      if (AB->M || nodeB == blocked) {
+        continue;
+      }
+
+      int ret = claimNode(update, nodeB, AB, BLUE);
+      if (ret == IGNORE) {
+        continue;
+      }
+      if (ret != OK) {
+        *status = ret;
+        break;
+      }
+
+      // free node ends an augmenting path
+      TEdge *BC = getM(nodeB);
+      if (BC == NULL) {
+        error = processPath(nodeB, path);
+        *status = PATH;
+        break;
+      }
+
+      ret = claimNode(update, BC->node, BC, RED);
+      if (ret == IGNORE) {
+        continue;
+      }
+      if (ret != OK) {
+        *status = ret;
+        break;
+      }
+
+      // enlarge the queue
+      if (last == qsize) {
+        TNode **queue = realloc(Q, 2 * qsize * sizeof(TNode*));
+        if (queue == NULL) {
+          error = EALLOC;
+          break;
+        }
+
+        Q = queue;
+        qsize *= 2;
+      }
+
+      Q[last++] = BC->node;
+    }
+  }
+
+  // OK means the root is dead
+  update->visited += 2 * last;
+
+  free(Q);
+  return error;
+}
+
+//------------------------------------------------------------------- REPAIR
+
+static int repairDelete(TUpdate *update, TGraph *graph, TList *path, int *status) {
+
+  TNode *A = &(graph->nodes[update->idA]);
+  TNode *B = &(graph->nodes[update->idB]);
+
+  *status = OK;
+  if (!update->matched) {
+    return EOK;
+  }
+
+  // M may lose one edge, one path from A or B is enough
+  int error = search(update, A, NULL, path, status);
+  if (error == EOK && *status == OK) {
+    error = search(update, B, NULL, path, status);
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int repairInsert(TUpdate *update, TGraph *graph, TList *path, int *status) {
+
+  TNode *A = &(graph->nodes[update->idA]);
+  TNode *B = &(graph->nodes[update->idB]);
+  TEdge *AA = getM(A);
+  TEdge *BB = getM(B);
+
+  // both nodes are free
+  if (AA == NULL && BB == NULL) {
+
+    TEdge *AB = A->edges;
+    while (AB->node != B) {
+      AB = AB->next;
+    }
+
+    changeM(AB);
+    *status = PATH;
+    return EOK;
+  }
+
+  // a path has to use the new edge and start in the free node
+  if (AA == NULL || BB == NULL) {
+    return search(update, (AA == NULL) ? A : B, NULL, path, status);
+  }
+
+  // both nodes are matched, try to move the mate of A
+  *status = claimNode(update, AA->node, AA, WHITE);
+  if (*status != OK) {
+    return EOK;
+  }
+
+  changeM(AA);
+  int error = search(update, AA->node, A, path, status);
+
+  if (error == EOK && *status == PATH) {
+    error = search(update, A, NULL, path, status);
+
+    if (error == EOK && *status == OK) {
+      *status = PATH;
+    }
+  }
+
+  // undo the changes if the search did not finish
+  if (error != EOK || *status == CONFLICT || *status == ABORT) {
+    undoPath(path);
+    changeM(AA);
+  }
+  else if (*status == OK) {
+    changeM(AA);
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int _repairUpdate(TJob *job, TWorker *worker) {
+
+  TUpdate *update = job->data;
+  TList path;
+  int status = OK;
+  int error = EOK;
+
+  DEBUG(msg("Repair update %" PRIINDEX " %" PRIINDEX ".", worker->id, update->idA, update->idB))
+  (void) worker;
+
+  initList(&path);
+
+  if (update->op == DELETE) {
+    error = repairDelete(update, job->graph, &path, &status);
+  }
+  else {
+    error = repairInsert(update, job->graph, &path, &status);
+  }
+
+  // conflicting updates are repeated in the next round
+  if (error == EOK && (status == PATH || status == OK)) {
+    update->state = REPAIRED;
+  }
+
+  freeList(&path);
+  return error;
+}
+
+//------------------------------------------------------------------- ROUNDS
+
+static int applyUpdate(TGraph *graph, TUpdate *update) {
+
+  // a removed matched edge leaves both nodes free
+  update->state = APPLIED;
+  update->matched = 0;
+
+  if (update->op == DELETE) {
+    return (removeEdge(graph, update->idA, update->idB, &(update->matched)) == EOK) ? OK : IGNORE;
+  }
+
+  return (addEdge(graph, update->idA, update->idB) == EOK) ? OK : ABORT;
+}
+
+//-------------------------------------------------------------------
+
+static void undoUpdate(TGraph *graph, TUpdate *update) {
+
+  // return the graph to the state before the update
+  update->state = NEW;
+
+  if (update->op == INSERT) {
+    int matched;
+    removeEdge(graph, update->idA, update->idB, &matched);
+    return;
+  }
+
+  // the removed edge left spare edges, no allocation is needed
+  addEdge(graph, update->idA, update->idB);
+
+  if (update->matched) {
+    changeM(graph->nodes[update->idA].edges);
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int _updateRound(TPool *pool, TGraph *graph, TUpdate **pending, TIndex n, TJob *jobs, TIndex limit, TIndex *active, TIndex *repaired) {
+
+  int error = EOK;
+  TIndex k = 0;
+
+  // claim both nodes of updates and change the graph
+  for (TIndex i = 0; i < n && k < limit; i++) {
+
+    TUpdate *update = pending[i];
+    TNode *A = &(graph->nodes[update->idA]);
+    TNode *B = &(graph->nodes[update->idB]);
+
+    if (A->tree != NULL || B->tree != NULL) {
+      continue;
+    }
+
+    int status = claimNode(update, A, NULL, WHITE);
+    if (status == OK) status = claimNode(update, B, NULL, WHITE);
+    if (status == OK) status = applyUpdate(graph, update);
+
+    if (status == ABORT) {
+      releaseNodes(update);
+      update->state = NEW;
+      error = EALLOC;
+      break;
+    }
+    if (status == IGNORE) {
+      update->state = REPAIRED;
+      error = EINPUT;
+    }
+
+    jobs[k].task = &_repairUpdate;
+    jobs[k].graph = graph;
+    jobs[k].data = update;
+    jobs[k].error = EOK;
+    jobs[k].done = 1;
+    k++;
+  }
+
+  // repair the claimed updates in parallel
+  for (TIndex i = 0; i < k; i++) {
+
+    TUpdate *update = jobs[i].data;
+    if (update->state == APPLIED && submitJob(pool, &jobs[i]) != EOK) {
+      error = EQUEUE;
+    }
+  }
+
+  waitJobs(pool, jobs, k);
+
+  // undo conflicting updates and release the nodes of the round
+  *active = k;
+  *repaired = 0;
+
+  for (TIndex i = 0; i < k; i++) {
+
+    TUpdate *update = jobs[i].data;
+
+    if (update->state == REPAIRED) {
+      (*repaired)++;
+    }
+    else {
+      undoUpdate(graph, update);
+    }
+
+    releaseNodes(update);
+
+    if (jobs[i].error != EOK) {
+      error = jobs[i].error;
+    }
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int _rematchGraph(TPool *pool, TGraph *graph, TUpdate **pending, TIndex n) {
+
+  int error = EOK;
+
+  // apply the rest of the batch without repairs
+  for (TIndex i = 0; i < n; i++) {
+
+    int status = applyUpdate(graph, pending[i]);
+    pending[i]->state = REPAIRED;
+
+    if (status == ABORT) {
+      return EALLOC;
+    }
+    if (status == IGNORE) {
+      error = EINPUT;
+    }
+  }
+
+  // the engine extends the matching to a maximum one
+  int ret = findMatchingInPool(pool, graph);
+  return (ret != EOK) ? ret : error;
+}
+
+//-------------------------------------------------------------------
+
+int updateMatching(TPool *pool, TGraph *graph, TUpdate *updates, TIndex n, int *rounds, int *rematched) {
+
+  int error = EOK;
+  *rounds = 0;
+  *rematched = 0;
+
+  TUpdate **pending = malloc((size_t) n * sizeof(TUpdate*));
+  TJob *jobs = malloc((size_t) n * sizeof(TJob));
+
+  if (n > 0 && (pending == NULL || jobs == NULL)) {
+    free(pending);
+    free(jobs);
+    return EALLOC;
+  }
+
+  // check updates
+  TIndex k = 0;
+
+  for (TIndex i = 0; i < n; i++) {
+
+    TUpdate *update = &(updates[i]);
+    update->state = NEW;
+    update->visited = 0;
+    update->tree.id = i;
+    update->tree.status = INPROCESS;
+    update->tree.owner = -1;
+    update->nodes = NULL;
+    update->count = 0;
+    update->size = 0;
+
+    if (update->idA == update->idB || update->idA < 0 || update->idB < 0
+       || update->idA >= graph->n || update->idB >= graph->n) {
+      error = EINPUT;
+      continue;
+    }
+
+    pending[k++] = update;
+  }
+
+  // repair the updates in rounds as wide as the pool
+  int64_t budget = (int64_t) graph->n + graph->m;
+  int64_t visited = 0;
+  TIndex limit = pool->n;
+
+  while (k > 0) {
+
+    TIndex active = 0;
+    TIndex repaired = 0;
+    int ret = _updateRound(pool, graph, pending, k, jobs, limit, &active, &repaired);
+    (*rounds)++;
+
+    if (ret != EOK) {
+      error = ret;
+      if (ret != EINPUT) break;
+    }
+
+    // widen the round after a round without conflicts, narrow it otherwise
+    if (repaired == active) {
+      limit = (limit < n / 2) ? 2 * limit : n;
+    }
+    else {
+      limit = (repaired > 0) ? repaired : 1;
+    }
+
+    // keep the order of pending updates
+    TIndex j = 0;
+    for (TIndex i = 0; i < k; i++) {
+
+      visited += pending[i]->visited;
+      pending[i]->visited = 0;
+
+      if (pending[i]->state != REPAIRED) {
+        pending[j++] = pending[i];
+      }
+    }
+
+    k = j;
+
+    // the searches cost more than matching of the whole graph
+    if (k > 0 && visited > budget) {
+      ret = _rematchGraph(pool, graph, pending, k);
+      *rematched = 1;
+
+      if (ret != EOK) error = ret;
+      break;
+    }
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    free(updates[i].nodes);
+  }
+
+  free(pending);
+  free(jobs);
+  return error;
+}
+
+/* end of file */
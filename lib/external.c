@@ -0,0 +1,347 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Semi-external matching. The compressed lists are written to a file in
+ * the order of nodes and mapped back, only the state of nodes stays in
+ * memory. The file is built in passes over the input, each pass sorts
+ * the lists of as many nodes as fit into the memory budget.
+ *
+ * File: header (magic EGVA, width, n, m), uint64 offsets[n + 1] of lists
+ * from the start of the data and the varint gaps of the lists.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- BUILD
+
+static int _validEdge(TIndex n, TIndex x, TIndex y) {
+  return (x != y && x >= 0 && y >= 0 && x < n && y < n);
+}
+
+//-------------------------------------------------------------------
+
+static int _scanInput(FILE *in, TReader *reader, TPhase *phase) {
+
+  if (fseek(in, 0, SEEK_SET) != 0) {
+    return EFILE;
+  }
+
+  int error = openReader(reader, in);
+  phase->bytes += ftell(in);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int _countDegrees(FILE *in, TReader *reader, uint64_t **degrees, TIndex *m, TPhase *phase) {
+
+  int error = _scanInput(in, reader, phase);
+  if (error != EOK) {
+    return error;
+  }
+
+  *degrees = calloc((size_t) reader->n + 1, sizeof(uint64_t));
+  if (*degrees == NULL) {
+    return EALLOC;
+  }
+
+  long start = ftell(in);
+  TIndex x, y;
+
+  while (nextEdge(reader, &x, &y)) {
+
+    if (_validEdge(reader->n, x, y)) {
+      (*degrees)[x]++;
+      (*degrees)[y]++;
+      (*m)++;
+    }
+  }
+
+  phase->bytes += ftell(in) - start;
+  return reader->error;
+}
+
+//-------------------------------------------------------------------
+
+static int _writeRange(FILE *in, FILE *out, TReader *reader, uint64_t *offsets,
+                       TIndex lo, TIndex hi, uint64_t *position, TPhase *phase) {
+
+  // lists of the range, the offsets still hold degrees
+  size_t total = 0;
+  size_t *starts = malloc(((size_t) (hi - lo) + 1) * sizeof(size_t));
+
+  if (starts == NULL) {
+    return EALLOC;
+  }
+
+  for (TIndex i = lo; i < hi; i++) {
+    starts[i - lo] = total;
+    total += offsets[i];
+  }
+
+  starts[hi - lo] = total;
+
+  TIndex *lists = malloc(total * sizeof(TIndex) + 1);
+  size_t *fill = malloc(((size_t) (hi - lo) + 1) * sizeof(size_t));
+
+  int error = (lists != NULL && fill != NULL) ? EOK : EALLOC;
+
+  if (error == EOK) {
+    memcpy(fill, starts, ((size_t) (hi - lo) + 1) * sizeof(size_t));
+    error = _scanInput(in, reader, phase);
+  }
+
+  // collect neighbours of the range in one pass over the input
+  if (error == EOK) {
+
+    long start = ftell(in);
+    TIndex x, y;
+
+    while (nextEdge(reader, &x, &y)) {
+
+      if (!_validEdge(reader->n, x, y)) continue;
+
+      if (x >= lo && x < hi) lists[fill[x - lo]++] = y;
+      if (y >= lo && y < hi) lists[fill[y - lo]++] = x;
+    }
+
+    phase->bytes += ftell(in) - start;
+    error = reader->error;
+  }
+
+  // sort and encode the lists
+  uint64_t size = 0;
+
+  for (TIndex i = lo; i < hi && error == EOK; i++) {
+    size += sortList(lists + starts[i - lo], starts[i - lo + 1] - starts[i - lo]);
+  }
+
+  uint8_t *bytes = (error == EOK) ? malloc(size + 1) : NULL;
+  if (error == EOK && bytes == NULL) {
+    error = EALLOC;
+  }
+
+  if (error == EOK) {
+
+    uint8_t *next = bytes;
+
+    for (TIndex i = lo; i < hi; i++) {
+      offsets[i] = *position + (next - bytes);
+      next = encodeList(next, lists + starts[i - lo], starts[i - lo + 1] - starts[i - lo]);
+    }
+
+    *position += size;
+
+    if (fwrite(bytes, 1, size, out) != size) {
+      error = EFILE;
+    }
+  }
+
+  free(bytes);
+  free(lists);
+  free(fill);
+  free(starts);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int _writeAdjacency(FILE *in, FILE *out, size_t budget, TPhase *phase) {
+
+  TReader *reader = malloc(sizeof(TReader));
+  uint64_t *offsets = NULL;
+  TIndex m = 0;
+
+  if (reader == NULL) {
+    return EALLOC;
+  }
+
+  // the first pass counts degrees
+  int error = _countDegrees(in, reader, &offsets, &m, phase);
+  TIndex n = reader->n;
+
+  // header and space for offsets
+  TBinaryHeader header;
+  memcpy(header.magic, ADJACENCY_MAGIC, 4);
+  header.width = sizeof(TIndex);
+  header.n = n;
+  header.m = m;
+
+  if (error == EOK
+     && (fwrite(&header, sizeof(header), 1, out) != 1
+        || fwrite(offsets, sizeof(uint64_t), (size_t) n + 1, out) != (size_t) n + 1)) {
+    error = EFILE;
+  }
+
+  // next passes write lists of ranges of nodes that fit into the budget
+  uint64_t limit = budget / (2 * sizeof(TIndex)) + 1;
+  uint64_t position = 0;
+  TIndex lo = 0;
+
+  while (error == EOK && lo < n) {
+
+    TIndex hi = lo;
+    uint64_t total = 0;
+
+    while (hi < n && (hi == lo || total + offsets[hi] <= limit)) {
+      total += offsets[hi];
+      hi++;
+    }
+
+    error = _writeRange(in, out, reader, offsets, lo, hi, &position, phase);
+    lo = hi;
+  }
+
+  // offsets are known at the end
+  if (error == EOK) {
+
+    offsets[n] = position;
+    phase->bytes += position;
+
+    if (fseek(out, sizeof(header), SEEK_SET) != 0
+       || fwrite(offsets, sizeof(uint64_t), (size_t) n + 1, out) != (size_t) n + 1) {
+      error = EFILE;
+    }
+  }
+
+  free(offsets);
+  free(reader);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int writeAdjacency(FILE *in, const char *fname, size_t budget, TPhase *phase) {
+
+  FILE *out = fopen(fname, "wb");
+  if (out == NULL) {
+    return EFILE;
+  }
+
+  beginPhase(phase);
+  int error = _writeAdjacency(in, out, budget, phase);
+
+  if (fclose(out) != 0 && error == EOK) {
+    error = EFILE;
+  }
+
+  endPhase(phase);
+
+  if (error != EOK) {
+    remove(fname);
+  }
+
+  return error;
+}
+
+//------------------------------------------------------------------- MAP
+
+static int _checkAdjacency(TCompressed *graph, const char *data, size_t size) {
+
+  TBinaryHeader header;
+
+  if (size < sizeof(header)) {
+    return EINPUT;
+  }
+
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header.magic, ADJACENCY_MAGIC, 4) != 0 || header.width != sizeof(TIndex)
+     || header.n > INDEX_MAX || header.m > EDGES_MAX) {
+    return EINPUT;
+  }
+
+  // the offsets and lists must lie in the file
+  if (header.n >= (size - sizeof(header)) / sizeof(uint64_t)) {
+    return EINPUT;
+  }
+
+  size_t lists = sizeof(header) + (header.n + 1) * sizeof(uint64_t);
+  const uint64_t *offsets = (const uint64_t*) (data + sizeof(header));
+
+  // every list lies between its offsets, the last one ends the file
+  if (offsets[0] != 0 || offsets[header.n] != size - lists) {
+    return EINPUT;
+  }
+
+  for (uint64_t i = 0; i < header.n; i++) {
+    if (offsets[i] > offsets[i + 1]) {
+      return EINPUT;
+    }
+  }
+
+  // and no varint runs past the end of the mapping
+  if (size > lists && (data[size - 1] & 0x80)) {
+    return EINPUT;
+  }
+
+  graph->n = (TIndex) header.n;
+  graph->m = (TIndex) header.m;
+  graph->offsets = offsets;
+  graph->bytes = (const uint8_t*) (data + lists);
+  graph->size = offsets[header.n];
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int mapCompressed(TCompressed *graph, const char *fname) {
+
+  initCompressed(graph);
+
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) {
+    return EFILE;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return EFILE;
+  }
+
+  if (st.st_size == 0) {
+    close(fd);
+    return EINPUT;
+  }
+
+  // the lists stay in the page cache, not in the heap
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return EFILE;
+  }
+
+  graph->map = map;
+  graph->mapSize = st.st_size;
+
+  int error = _checkAdjacency(graph, map, st.st_size);
+
+  if (error == EOK) {
+    graph->mates = malloc((size_t) graph->n * sizeof(TIndex) + 1);
+    error = (graph->mates != NULL) ? EOK : EALLOC;
+  }
+
+  if (error == EOK) {
+    for (TIndex i = 0; i < graph->n; i++) {
+      graph->mates[i] = -1;
+    }
+  }
+
+  return error;
+}
+
+/* end of file */
@@ -0,0 +1,666 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- GRAPH
+
+static int _initGraph(TGraph *graph, TIndex n, TIndex m, int error) {
+
+  // init graph
+  graph->n = n;
+  graph->m = 0;
+  graph->maxm = m;
+  graph->used = 0;
+  graph->ntree = 0;
+  graph->bound = -1;
+  graph->nodes = graph->nodesMemory.ptr;
+  graph->edges = graph->edgesMemory.ptr;
+  graph->spare = NULL;
+
+  if (error != EOK) {
+    graph->n = 0;
+    graph->maxm = 0;
+    return error;
+  }
+  
+  // init nodes
+  TNode *node = NULL;
+  for (TIndex i = 0; i < n; i++) {
+  
+    node = &(graph->nodes[i]);
+    node->id = i;
+    node->colour = WHITE;
+    node->edges = NULL;
+    node->entry = NULL;
+    node->tree = NULL;
+    node->depth = 0;
+    
+    pthread_mutex_init(&(node->mutex), NULL); 
+  }
+  
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int initGraph(TGraph *graph, TIndex n, TIndex m) {
+
+  // allocate nodes and edges
+  int error = allocMemory(&(graph->nodesMemory), (size_t) n * sizeof(TNode));
+  if (error == EOK) {
+    error = allocMemory(&(graph->edgesMemory), 2 * (size_t) m * sizeof(TEdge));
+  }
+  else {
+    allocMemory(&(graph->edgesMemory), 0);
+  }
+
+  // init graph mutex
+  pthread_mutex_init(&(graph->mutex), NULL); 
+
+  return _initGraph(graph, n, m, error);
+}
+
+//-------------------------------------------------------------------
+
+int reuseGraph(TGraph *graph, TIndex n, TIndex m) {
+
+  // destroy old node mutexes
+  for (TIndex i = 0; i < graph->n; i++) {
+    pthread_mutex_destroy(&(graph->nodes[i].mutex));
+  }
+
+  // reuse nodes and edges if they are large enough
+  int error = resizeMemory(&(graph->nodesMemory), (size_t) n * sizeof(TNode));
+  if (error == EOK) {
+    error = resizeMemory(&(graph->edgesMemory), 2 * (size_t) m * sizeof(TEdge));
+  }
+
+  return _initGraph(graph, n, m, error);
+}
+
+//-------------------------------------------------------------------
+
+void resetSearch(TGraph *graph) {
+
+  // forget trees of the previous search, keep the matching
+  graph->ntree = 0;
+  graph->bound = -1;
+  
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    TNode *node = &(graph->nodes[i]);
+    node->colour = WHITE;
+    node->entry = NULL;
+    node->tree = NULL;
+  }
+}
+
+//-------------------------------------------------------------------
+
+void freeGraph(TGraph *graph) {
+
+  // destroy node mutexes
+  for (TIndex i = 0; i < graph->n; i++) {
+    pthread_mutex_destroy(&(graph->nodes[i].mutex));
+  }
+  
+  // free nodes and edges
+  freeMemory(&(graph->nodesMemory));
+  freeMemory(&(graph->edgesMemory));
+  graph->nodes = NULL;
+  graph->edges = NULL;
+
+  // free mutex
+  pthread_mutex_destroy(&(graph->mutex));  
+}
+
+//-------------------------------------------------------------------
+
+#define REBASE(edge) ((edge) == NULL ? NULL : edges + ((edge) - old))
+
+int growGraph(TGraph *graph, TIndex m) {
+
+  if (m <= graph->maxm) {
+    return EOK;
+  }
+
+  if (m > EDGES_MAX) {
+    return EINDEX;
+  }
+
+  // allocate larger edge storage
+  TMemory memory;
+  int error = allocMemory(&memory, 2 * (size_t) m * sizeof(TEdge));
+  if (error != EOK) {
+    return error;
+  }
+
+  TEdge *old = graph->edges;
+  TEdge *edges = memory.ptr;
+
+  if (graph->used > 0) {
+    memcpy(edges, old, 2 * (size_t) graph->used * sizeof(TEdge));
+  }
+
+  // move pointers of edges and nodes to the new storage
+  for (size_t i = 0; i < 2 * (size_t) graph->used; i++) {
+    edges[i].reversed = REBASE(edges[i].reversed);
+    edges[i].next = REBASE(edges[i].next);
+  }
+
+  for (TIndex i = 0; i < graph->n; i++) {
+    graph->nodes[i].edges = REBASE(graph->nodes[i].edges);
+    graph->nodes[i].entry = REBASE(graph->nodes[i].entry);
+  }
+
+  graph->spare = REBASE(graph->spare);
+
+  // replace the storage
+  freeMemory(&(graph->edgesMemory));
+  graph->edgesMemory = memory;
+  graph->edges = edges;
+  graph->maxm = m;
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int addEdge(TGraph *graph, TIndex idA, TIndex idB) {
+
+  // check input
+  if (idA == idB || idA < 0 || idB < 0 || idA >= graph->n || idB >= graph->n) {
+    return EINPUT;
+  }
+
+  // check capacity, double the storage if it is full
+  if (graph->spare == NULL && graph->used >= graph->maxm) {
+
+    if (graph->used >= EDGES_MAX) {
+      return EINDEX;
+    }
+
+    TIndex m = (graph->maxm > EDGES_MAX / 2) ? EDGES_MAX : 2 * graph->maxm;
+    int error = growGraph(graph, m > 0 ? m : 16);
+    if (error != EOK) {
+      return error;
+    }
+  }
+
+  // get nodes
+  TNode *A = &(graph->nodes[idA]);
+  TNode *B = &(graph->nodes[idB]);
+    
+  // take edges from removed edges or from the edge storage
+  TEdge *edgeAB = graph->spare;
+
+  if (edgeAB != NULL) {
+    graph->spare = edgeAB->next;
+  }
+  else {
+    edgeAB = &(graph->edges[2 * (size_t) graph->used]);
+    graph->used++;
+  }
+
+  TEdge *edgeBA = edgeAB + 1;
+  
+  // init edge from A to B
+  edgeAB->M = 0;
+  edgeAB->node = B;
+  edgeAB->reversed = edgeBA;
+  edgeAB->next = A->edges;
+  A->edges = edgeAB;
+  
+  // init edge from B to A
+  edgeBA->M = 0;
+  edgeBA->node = A;
+  edgeBA->reversed = edgeAB;
+  edgeBA->next = B->edges;
+  B->edges = edgeBA;
+  
+  // increment number of edges
+  graph->m++;
+  
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static void _unlinkEdge(TNode *node, TEdge *edge) {
+
+  TEdge **link = &(node->edges);
+
+  while (*link != edge) {
+    link = &((*link)->next);
+  }
+
+  *link = edge->next;
+}
+
+//-------------------------------------------------------------------
+
+int removeEdge(TGraph *graph, TIndex idA, TIndex idB, int *matched) {
+
+  // check input
+  if (idA == idB || idA < 0 || idB < 0 || idA >= graph->n || idB >= graph->n) {
+    return EINPUT;
+  }
+
+  TNode *A = &(graph->nodes[idA]);
+  TNode *B = &(graph->nodes[idB]);
+
+  // find the edge, prefer an unmatched one of parallel edges
+  TEdge *edge = NULL;
+
+  for (TEdge *e = A->edges; e != NULL; e = e->next) {
+    if (e->node == B && (edge == NULL || edge->M)) {
+      edge = e;
+    }
+  }
+
+  if (edge == NULL) {
+    return EINPUT;
+  }
+
+  // remove the edge from the matching and from both nodes
+  *matched = edge->M;
+  _unlinkEdge(A, edge);
+  _unlinkEdge(B, edge->reversed);
+
+  // return the pair of edges to the storage
+  TEdge *pair = (edge < edge->reversed) ? edge : edge->reversed;
+  pair->M = 0;
+  pair->node = NULL;
+  (pair + 1)->M = 0;
+  (pair + 1)->node = NULL;
+  pair->next = graph->spare;
+  graph->spare = pair;
+
+  graph->m--;
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int matchEdge(TGraph *graph, TIndex idA, TIndex idB) {
+
+  if (idA == idB || idA < 0 || idB < 0 || idA >= graph->n || idB >= graph->n) {
+    return EINPUT;
+  }
+
+  TNode *A = &(graph->nodes[idA]);
+  TNode *B = &(graph->nodes[idB]);
+
+  // both nodes have to be free
+  if (inM(A) || inM(B)) {
+    return EINPUT;
+  }
+
+  for (TEdge *edge = A->edges; edge != NULL; edge = edge->next) {
+    if (edge->node == B) {
+      changeM(edge);
+      return EOK;
+    }
+  }
+
+  return EINPUT;
+}
+
+//-------------------------------------------------------------------
+
+static int _isMatched(TGraph *graph, TIndex idA, TIndex idB) {
+
+  for (TEdge *edge = graph->nodes[idA].edges; edge != NULL; edge = edge->next) {
+    if (edge->M && edge->node->id == idB) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int _loadMates(TGraph *graph, FILE *f) {
+
+  TBinaryHeader header;
+
+  if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, MATES_MAGIC, 4) != 0
+     || (header.width != sizeof(uint32_t) && header.width != sizeof(uint64_t))
+     || header.n != (uint64_t) graph->n) {
+    return EINPUT;
+  }
+
+  // mates of a few nodes at once
+  uint64_t chunk[READER_CHUNK];
+  size_t count = sizeof(chunk) / header.width;
+  int error = EOK;
+
+  for (TIndex i = 0; i < graph->n && error == EOK; ) {
+
+    size_t read = ((uint64_t) (graph->n - i) < count) ? (size_t) (graph->n - i) : count;
+    if (fread(chunk, header.width, read, f) != read) {
+      return EINPUT;
+    }
+
+    for (size_t k = 0; k < read && error == EOK; k++, i++) {
+
+      TIndex mate = getBinaryId(chunk, header.width, k);
+
+      // the pair is matched from its smaller node, the other one agrees
+      if (i < mate) {
+        error = matchEdge(graph, i, mate);
+      }
+      else if (inM(&(graph->nodes[i])) != (mate >= 0) || (mate >= 0 && !_isMatched(graph, i, mate))) {
+        error = EINPUT;
+      }
+    }
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int loadMatching(TGraph *graph, FILE *f) {
+
+  // the binary array of mates
+  int c = fgetc(f);
+  ungetc(c, f);
+
+  if (c == MATES_MAGIC[0]) {
+    return _loadMates(graph, f);
+  }
+
+  int sections = 0;
+  TIndex id = 0, count = 0, ids[2];
+  char name[16];
+
+  // read pairs "A B" or "(A,B)" until a section other than <Matching>
+  while ((c = fgetc(f)) != EOF) {
+
+    if (c == '<') {
+
+      if (fscanf(f, "%15[^>]>", name) != 1 || strcmp(name, "Matching") != 0 || sections++ > 0) {
+        break;
+      }
+    }
+    else if (c >= '0' && c <= '9') {
+
+      ungetc(c, f);
+      if (fscanf(f, "%" SCNINDEX, &id) != 1) {
+        return EINPUT;
+      }
+
+      ids[count % 2] = id;
+      count++;
+
+      if (count % 2 == 0 && matchEdge(graph, ids[0], ids[1]) != EOK) {
+        return EINPUT;
+      }
+    }
+  }
+
+  return (count % 2 == 0) ? EOK : EINPUT;
+}
+
+//-------------------------------------------------------------------
+
+static int _prepareGraph(TGraph *graph, TIndex n, TIndex m, int reuse) {
+
+  if (reuse) {
+    return reuseGraph(graph, n, m);
+  }
+
+  return initGraph(graph, n, m);
+}
+
+//-------------------------------------------------------------------
+
+int checkHeader(TBinaryHeader *header) {
+
+  if (memcmp(header->magic, BINARY_MAGIC, 4) != 0
+      || (header->width != sizeof(uint32_t) && header->width != sizeof(uint64_t))) {
+    return EINPUT;
+  }
+
+  // wider graphs need the 64-bit build
+  if (header->n > INDEX_MAX || header->m > EDGES_MAX) {
+    return EINDEX;
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+TIndex getBinaryId(const void *ids, uint32_t width, size_t i) {
+
+  uint64_t id = (width == sizeof(uint64_t)) ? ((const uint64_t*) ids)[i] : ((const uint32_t*) ids)[i];
+  return (id <= INDEX_MAX) ? (TIndex) id : -1;
+}
+
+//-------------------------------------------------------------------
+
+int openReader(TReader *reader, FILE *f) {
+
+  reader->f = f;
+  reader->width = 0;
+  reader->n = 0;
+  reader->m = 0;
+  reader->read = 0;
+  reader->count = 0;
+  reader->pos = 0;
+  reader->error = EOK;
+
+  // skip white spaces and look at the first character
+  int c = ' ';
+  while(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    c = getc(f);
+  }
+  
+  ungetc(c, f);
+
+  // binary graphs start with the magic
+  if (c == BINARY_MAGIC[0]) {
+
+    TBinaryHeader header;
+    int error = (fread(&header, sizeof(TBinaryHeader), 1, f) == 1) ? checkHeader(&header) : EINPUT;
+    if (error != EOK) {
+      return error;
+    }
+
+    reader->width = header.width;
+    reader->n = (TIndex) header.n;
+    reader->m = (TIndex) header.m;
+    return EOK;
+  }
+
+  // read numbers of vertices and edges
+  int64_t n = 0, m = 0;
+
+  if(fscanf(f, "%" SCNd64 " %" SCNd64, &n, &m) != 2 || n < 0 || m < 0) {
+    return EINPUT;
+  }
+
+  // wider graphs need the 64-bit build
+  if (n > INDEX_MAX || m > EDGES_MAX) {
+    return EINDEX;
+  }
+
+  reader->n = (TIndex) n;
+  reader->m = (TIndex) m;
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int nextEdge(TReader *reader, TIndex *x, TIndex *y) {
+
+  if (reader->read == reader->m || reader->error != EOK) {
+    return 0;
+  }
+
+  // text graphs
+  if (reader->width == 0) {
+
+    if(fscanf(reader->f, "%" SCNINDEX " %" SCNINDEX, x, y) != 2) {
+      reader->error = EINPUT;
+      return 0;
+    }
+
+    reader->read++;
+    return 1;
+  }
+
+  // binary graphs are read in chunks
+  if (reader->pos == reader->count) {
+
+    TIndex left = reader->m - reader->read;
+    reader->count = (left < READER_CHUNK) ? (size_t) left : READER_CHUNK;
+    reader->pos = 0;
+
+    if (fread(reader->chunk, 2 * reader->width, reader->count, reader->f) != reader->count) {
+      reader->error = EINPUT;
+      return 0;
+    }
+  }
+
+  *x = getBinaryId(reader->chunk, reader->width, 2 * reader->pos);
+  *y = getBinaryId(reader->chunk, reader->width, 2 * reader->pos + 1);
+
+  reader->pos++;
+  reader->read++;
+  return 1;
+}
+
+//-------------------------------------------------------------------
+
+static int _loadGraph(TGraph *graph, FILE *f, int reuse) {
+
+  TReader reader;
+  int error = openReader(&reader, f);
+
+  if (error != EOK) {
+    _prepareGraph(graph, 0, 0, reuse);
+    return error;
+  }
+
+  // init graph
+  error = _prepareGraph(graph, reader.n, reader.m, reuse);
+  if (error != EOK) {
+    return error;
+  }
+
+  // read edges
+  TIndex x, y;
+
+  while (nextEdge(&reader, &x, &y)) {
+    addEdge(graph, x, y);
+  }
+
+  return reader.error;
+}
+
+int loadGraph(TGraph *graph, FILE *f) {
+  return _loadGraph(graph, f, 0);
+}
+
+int reloadGraph(TGraph *graph, FILE *f) {
+  return _loadGraph(graph, f, 1);
+}
+
+//-------------------------------------------------------------------
+
+int isBinaryGraph(const char *data, size_t size) {
+  return (size >= sizeof(TBinaryHeader) && memcmp(data, BINARY_MAGIC, 4) == 0);
+}
+
+//-------------------------------------------------------------------
+
+static int _reloadGraphBinary(TGraph *graph, const char *data, size_t size) {
+
+  TBinaryHeader header;
+  memcpy(&header, data, sizeof(TBinaryHeader));
+
+  // check the header
+  int error = checkHeader(&header);
+  if (error == EOK && (size - sizeof(TBinaryHeader)) / (2 * header.width) < header.m) {
+    error = EINPUT;
+  }
+
+  if (error != EOK) {
+    reuseGraph(graph, 0, 0);
+    return error;
+  }
+
+  error = reuseGraph(graph, (TIndex) header.n, (TIndex) header.m);
+  if (error != EOK) {
+    return error;
+  }
+
+  // read edges
+  const void *edges = data + sizeof(TBinaryHeader);
+
+  for (uint64_t i = 0; i < header.m; i++) {
+    addEdge(graph, getBinaryId(edges, header.width, 2 * i), getBinaryId(edges, header.width, 2 * i + 1));
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+int reloadGraphData(TGraph *graph, char *data, size_t size) {
+
+  // binary graph
+  if (isBinaryGraph(data, size)) {
+    return _reloadGraphBinary(graph, data, size);
+  }
+
+  // text graph
+  FILE *f = (size > 0) ? fmemopen(data, size, "r") : NULL;
+  if (f == NULL) {
+    reuseGraph(graph, 0, 0);
+    return EINPUT;
+  }
+
+  int error = reloadGraph(graph, f);
+  fclose(f);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void printGraph(TGraph *graph, FILE *f) {
+
+  fprintf(f, "<Graph>\n");
+  for (TIndex i = 0; i < graph->n; i++) {
+  
+    TNode *node = &(graph->nodes[i]);
+    if (node != NULL) {
+    
+      fprintf(f, "Node %" PRIINDEX ": ", node->id);  
+
+      TEdge *edge = node->edges;      
+      while(edge != NULL) {
+      
+        fprintf(f, "%" PRIINDEX "[%d] ", edge->node->id, edge->M);  
+        edge = edge->next;
+      }
+      
+      fprintf(f, "\n");  
+    }
+  }
+}
+
+/* end of file */
@@ -0,0 +1,694 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Internal types and functions of libmatching shared by the engines
+ * and the front ends.
+ */
+
+#ifndef INTERNAL_H
+#define INTERNAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "matching.h"
+
+#define DEBUG(y) //y;
+
+#ifdef INDEX64
+#define INDEX_MAX INT64_MAX
+#define PRIINDEX  PRId64
+#define SCNINDEX  SCNd64
+#else
+#define INDEX_MAX INT32_MAX
+#define PRIINDEX  PRId32
+#define SCNINDEX  SCNd32
+#endif
+
+// every edge takes two slots, so 2 * m fits into TIndex
+#define EDGES_MAX (INDEX_MAX / 2)
+
+//------------------------------------------------------------------- ENUMS
+
+enum colours {
+  RED = 0,
+  BLUE,
+  GREEN,
+  WHITE
+};
+
+enum treestat {
+  FREE = 0,
+  INPROCESS,
+  HASPATH,
+  APSTREE
+};
+
+enum retstat {
+  OK = 0,
+  ABORT,
+  IGNORE,
+  CONFLICT,
+  PATH
+};
+
+enum updates {
+  INSERT = 0,
+  DELETE
+};
+
+enum updstat {
+  NEW = 0,
+  APPLIED,
+  REPAIRED
+};
+
+enum phases {
+  BUILD = 0,
+  GREEDY,
+  SEARCH
+};
+
+enum traces {
+  TREE_SPAN = 0,
+  NODE_WAIT,
+  TREE_WAIT,
+  GRAPH_WAIT,
+  QUEUE_WAIT,
+  REQUEUE
+};
+
+enum locks {
+  NODE_LOCK = 0,
+  TREE_LOCK,
+  GRAPH_LOCK,
+  QUEUE_LOCK,
+  LOCK_CLASSES
+};
+
+enum ends {
+  AUGMENTED = 0,
+  HUNGARIAN,
+  ABORTED,
+  CUT
+};
+
+enum stages {
+  LOAD = 0,
+  MATCH,
+  OUTPUT,
+  PREPARE
+};
+
+enum formats {
+  TEXT = 0,
+  BINARY,
+  QUIET
+};
+
+enum checks {
+  NOCHECK = 0,
+  VERIFY,
+  DECOMPOSE
+};
+
+enum parts {
+  HORIZONTAL = 0,
+  SQUARE,
+  VERTICAL
+};
+
+enum backing {
+  HEAP = 0,
+  PAGES,
+  THP,
+  HUGETLB
+};
+
+//------------------------------------------------------------------- TYPES
+
+typedef struct tMemory TMemory;
+typedef struct tTree TTree;
+typedef struct tNode TNode;
+typedef struct tEdge TEdge;
+
+typedef struct tList TList;
+typedef struct tQueue TQueue;
+typedef struct tItem TItem;
+
+typedef pthread_t TThread;
+typedef pthread_mutex_t TMutex;
+typedef pthread_cond_t TCond;
+
+typedef struct tPool TPool;
+typedef struct tWorker TWorker;
+typedef struct tJob TJob;
+typedef struct tUpdate TUpdate;
+
+typedef struct tReader TReader;
+typedef struct tCompressed TCompressed;
+typedef struct tCursor TCursor;
+typedef struct tPhase TPhase;
+typedef struct tStream TStream;
+typedef struct tLimits TLimits;
+typedef struct tCertificate TCertificate;
+typedef struct tDecomposition TDecomposition;
+typedef struct tStats TStats;
+typedef struct tEvent TEvent;
+typedef struct tTrace TTrace;
+typedef struct tLockStats TLockStats;
+typedef struct tCounters TCounters;
+typedef struct tSample TSample;
+typedef struct tPerf TPerf;
+typedef struct tBench TBench;
+
+struct tList {
+  TItem *last;
+};
+
+struct tQueue {
+  TItem *first;
+  TItem *last;
+};
+
+struct tItem {
+  void *item;
+  TItem *next;
+};
+
+struct tMemory {
+  void *ptr;
+  size_t size;
+  int backing;
+};
+
+struct tGraph {
+  TIndex n;
+  TIndex m;
+  TIndex maxm;
+  TIndex used;
+  TNode *nodes;
+  TEdge *edges;
+  TEdge *spare;
+
+  TMemory nodesMemory;
+  TMemory edgesMemory;
+
+  TIndex ntree;
+  double bound;
+  TMutex mutex;
+};
+
+struct tTree {
+  TIndex id;
+  int status;
+  int owner;
+  TIndex size;
+  TWorker *worker;
+
+  TNode *root;
+  TNode *pathEnd;
+
+  TList nodes;
+  TMutex mutex;
+
+  TTree *next;
+};
+
+struct tNode {
+  TIndex id;
+  int colour;
+  int depth;
+
+  TEdge *edges;
+  TEdge *entry;
+  TTree *tree;
+  TMutex mutex;
+};
+
+struct tEdge {
+  int M;
+  TNode *node;
+  TEdge *reversed;
+  TEdge *next;
+};
+
+#define STATS_BUCKETS 32
+
+struct tStats {
+  uint64_t trees;
+  uint64_t augmentations;
+  uint64_t apsTrees;
+  uint64_t aborts;
+  uint64_t edges;
+  uint64_t outcomes[PATH + 1];
+  uint64_t paths[STATS_BUCKETS];
+  uint64_t sizes[STATS_BUCKETS];
+};
+
+struct tEvent {
+  uint64_t start;
+  uint64_t duration;
+  TIndex root;
+  TIndex nodes;
+  uint8_t type;
+  uint8_t end;
+};
+
+struct tTrace {
+  size_t size;
+  uint64_t count;
+  TEvent events[];
+};
+
+struct tLockStats {
+  uint64_t acquired;
+  uint64_t contended;
+  uint64_t wait;
+};
+
+#define PERF_EVENTS 5
+#define PERF_STAGES 3
+
+struct tCounters {
+  int open;
+  int fds[PERF_EVENTS];
+};
+
+struct tSample {
+  uint64_t values[PERF_EVENTS];
+  uint64_t time;
+  uint64_t cpu;
+  long faults;
+  long switches;
+  uint64_t edges;
+  int done;
+};
+
+struct tPerf {
+  TCounters main;
+  TSample start;
+  TSample stages[PERF_STAGES];
+};
+
+#define BENCH_STAGES 4
+#define BENCH_TRIALS 10
+
+struct tBench {
+  int trials;
+  int count[BENCH_STAGES];
+  uint64_t *samples[BENCH_STAGES];
+  TIndex M;
+  int stable;
+};
+
+struct tWorker {
+  int id;
+  TThread thread;
+  TPool *pool;
+  TTree *spare;
+  TStats stats;
+  TTrace *trace;
+  TLockStats locks[LOCK_CLASSES];
+  TCounters counters;
+};
+
+struct tJob {
+  int (*task)(TJob *job, TWorker *worker);
+  int error;
+  int done;
+
+  TGraph *graph;
+  TQueue *queue;
+  TQueue *deferred;
+  TMutex *mutex;
+  void *data;
+};
+
+struct tUpdate {
+  int op;
+  TIndex idA;
+  TIndex idB;
+  int state;
+  int matched;
+  TIndex visited;
+
+  TTree tree;
+  TNode **nodes;
+  TIndex count;
+  TIndex size;
+};
+
+#define READER_CHUNK 4096
+
+struct tReader {
+  FILE *f;
+  uint32_t width;
+  TIndex n;
+  TIndex m;
+  TIndex read;
+  int error;
+
+  size_t count;
+  size_t pos;
+  uint64_t chunk[2 * READER_CHUNK];
+};
+
+struct tPhase {
+  uint64_t bytes;
+  double time;
+  long faults;
+};
+
+struct tCompressed {
+  TIndex n;
+  TIndex m;
+  TIndex ntree;
+
+  const uint64_t *offsets;
+  const uint8_t *bytes;
+  uint64_t size;
+
+  TIndex *mates;
+
+  void *map;
+  size_t mapSize;
+  TPhase phases[3];
+};
+
+struct tCursor {
+  const uint8_t *next;
+  const uint8_t *end;
+  TIndex id;
+};
+
+struct tStream {
+  TIndex n;
+  TIndex m;
+  TIndex M;
+  TIndex greedy;
+  int passes;
+  double bound;
+
+  TIndex *mates;
+  TIndex *roots;
+  TIndex *parents;
+  int *layers;
+  uint8_t *dead;
+};
+
+struct tLimits {
+  const struct timespec *deadline;
+  int length;
+  int cancel;      // give up trees in progress at the deadline
+};
+
+struct tCertificate {
+  TIndex M;
+  TIndex size;
+  TIndex uncovered;
+  int valid;
+  int verified;
+
+  TIndex *mates;
+  uint8_t *side;
+  uint8_t *cover;
+};
+
+struct tDecomposition {
+  TIndex n;
+  TIndex nblocks;
+
+  uint8_t *cover;
+  uint8_t *part;
+  TIndex *block;
+};
+
+struct tPool {
+  int n;
+  int pending;
+  int stop;
+  TWorker *workers;
+  uint64_t start;
+  int counting;
+
+  TQueue jobs;
+  TMutex mutex;
+  TCond work;
+  TCond done;
+};
+
+//------------------------------------------------------------------- LIST
+
+void initList(TList *L);
+int isEmptyList(TList *L);
+int pushList(TList *L, void *item);
+void* popList(TList *L);
+void freeList(TList *L);
+
+//------------------------------------------------------------------- QUEUE
+
+void initQueue(TQueue *Q);
+int isEmptyQueue(TQueue *Q);
+int pushQueue(TQueue *Q, void *item);
+void* popQueue(TQueue *Q);
+void freeQueue(TQueue *Q);
+
+//------------------------------------------------------------------- MEMORY
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+const char *backingName(int backing);
+int allocMemory(TMemory *mem, size_t size);
+int resizeMemory(TMemory *mem, size_t size);
+void freeMemory(TMemory *mem);
+
+//------------------------------------------------------------------- GRAPH
+
+#define BINARY_MAGIC "EGVB"
+
+typedef struct tBinaryHeader TBinaryHeader;
+
+struct tBinaryHeader {
+  char magic[4];
+  uint32_t width;
+  uint64_t n;
+  uint64_t m;
+};
+
+int initGraph(TGraph *graph, TIndex n, TIndex m);
+int reuseGraph(TGraph *graph, TIndex n, TIndex m);
+void freeGraph(TGraph *graph);
+void resetSearch(TGraph *graph);
+int growGraph(TGraph *graph, TIndex m);
+int removeEdge(TGraph *graph, TIndex idA, TIndex idB, int *matched);
+
+int checkHeader(TBinaryHeader *header);
+TIndex getBinaryId(const void *ids, uint32_t width, size_t i);
+
+int openReader(TReader *reader, FILE *f);
+int nextEdge(TReader *reader, TIndex *x, TIndex *y);
+
+int loadGraph(TGraph *graph, FILE *f);
+int reloadGraph(TGraph *graph, FILE *f);
+int isBinaryGraph(const char *data, size_t size);
+int matchEdge(TGraph *graph, TIndex idA, TIndex idB);
+int loadMatching(TGraph *graph, FILE *f);
+int reloadGraphData(TGraph *graph, char *data, size_t size);
+
+void printGraph(TGraph *graph, FILE *f);
+
+//------------------------------------------------------------------- MATCHING
+
+void lockNode(TNode *node);
+void unlockNode(TNode *node);
+void colourNodes(TTree *tree, int colour);
+
+int inM(TNode *node);
+void changeM(TEdge *edge);
+
+int isLate(const struct timespec *deadline);
+void initDeadline(struct timespec *deadline, double seconds);
+double qualityBound(TIndex M, TIndex free, int length);
+
+int findMatchingSequence(TGraph *graph);
+int findMatchingSequenceBounded(TGraph *graph, const TLimits *limits);
+
+//------------------------------------------------------------------- POOL
+
+#define SMALLGRAPH 65536
+
+int initPool(TPool *pool, int n);
+int submitJob(TPool *pool, TJob *job);
+void waitPool(TPool *pool);
+void waitJobs(TPool *pool, TJob *jobs, int n);
+void freePool(TPool *pool);
+
+int initRoots(TGraph *graph, TQueue *Q);
+int runRoots(TPool *pool, TGraph *graph, TQueue *Q, const TLimits *limits);
+
+int _findMatchingAlone(TJob *job, TWorker *worker);
+int findMatchingInPool(TPool *pool, TGraph *graph);
+int findMatchingBounded(TPool *pool, TGraph *graph, const TLimits *limits);
+int findMatching(TGraph *graph, int n);
+
+//------------------------------------------------------------------- STATS
+
+// histograms count values in buckets [2^i, 2^(i + 1))
+static inline void countStat(uint64_t *buckets, uint64_t value) {
+  int i = (value > 1) ? 63 - __builtin_clzll(value) : 0;
+  buckets[(i < STATS_BUCKETS) ? i : STATS_BUCKETS - 1]++;
+}
+
+void mergeStats(TPool *pool, TStats *total);
+void printStats(TPool *pool, FILE *f);
+
+//------------------------------------------------------------------- TRACE
+
+#define TRACE_EVENTS 65536
+
+uint64_t traceClock(void);
+void traceEvent(TTrace *trace, int type, uint64_t start, TIndex root, int end, TIndex nodes);
+int initTrace(TPool *pool, size_t size);
+void freeTrace(TPool *pool);
+int writeTrace(TPool *pool, FILE *f);
+
+//------------------------------------------------------------------- LOCKS
+
+#ifdef LOCKSTATS
+#define IFLOCKSTATS(y) y;
+#else
+#define IFLOCKSTATS(y)
+#endif
+
+void lockCounted(TMutex *mutex, TWorker *worker, int class);
+void printLocks(TPool *pool, FILE *f);
+
+// locks of the search, counted with -DLOCKSTATS and traced with a trace
+static inline void lockMutex(TMutex *mutex, TWorker *worker, int class) {
+
+#ifndef LOCKSTATS
+  if (worker == NULL || worker->trace == NULL) {
+    pthread_mutex_lock(mutex);
+    return;
+  }
+#endif
+
+  lockCounted(mutex, worker, class);
+}
+
+//------------------------------------------------------------------- PERF
+
+void openCounters(TCounters *counters);
+void closeCounters(TCounters *counters);
+void initPerf(TPerf *perf);
+void beginPerf(TPerf *perf, TPool *pool);
+void endPerf(TPerf *perf, TPool *pool, int stage, uint64_t edges);
+void freePerf(TPerf *perf);
+void printPerf(TPerf *perf, FILE *f);
+
+//------------------------------------------------------------------- BENCH
+
+int initBench(TBench *bench, int trials);
+void addSample(TBench *bench, int stage, uint64_t time);
+void freeBench(TBench *bench);
+void clearMatching(TGraph *graph);
+int benchMatching(TPool *pool, TGraph *graph, TBench *bench);
+double medianBench(TBench *bench, int stage);
+void printBench(TBench *bench, const char *engine, const char *name, int threads, FILE *f);
+
+//------------------------------------------------------------------- CHECKPOINT
+
+#define SNAPSHOT_MAGIC "EGVS"
+
+int saveSnapshot(TGraph *graph, TQueue *Q, const char *fname);
+int loadSnapshot(TGraph *graph, TQueue *Q, const char *fname);
+int findMatchingCheckpoint(TPool *pool, TGraph *graph, const char *fname, int interval, int resume);
+
+//------------------------------------------------------------------- COMPRESSED
+
+#define ADJACENCY_MAGIC "EGVA"
+
+uint64_t sortList(TIndex *list, size_t count);
+uint8_t *encodeList(uint8_t *bytes, const TIndex *list, size_t count);
+
+void beginPhase(TPhase *phase);
+void endPhase(TPhase *phase);
+
+void initCompressed(TCompressed *graph);
+int loadCompressed(TCompressed *graph, FILE *f);
+int writeAdjacency(FILE *in, const char *fname, size_t budget, TPhase *phase);
+int mapCompressed(TCompressed *graph, const char *fname);
+void freeCompressed(TCompressed *graph);
+int findMatchingCompressed(TCompressed *graph);
+void printCompressed(TCompressed *graph, FILE *f);
+
+// neighbours are sorted and stored as varint gaps, the first one from zero
+static inline void initCursor(TCursor *cursor, const TCompressed *graph, TIndex id) {
+  cursor->next = graph->bytes + graph->offsets[id];
+  cursor->end = graph->bytes + graph->offsets[id + 1];
+  cursor->id = 0;
+}
+
+static inline int nextNeighbour(TCursor *cursor, TIndex *id) {
+
+  if (cursor->next == cursor->end) {
+    return 0;
+  }
+
+  uint64_t gap = *(cursor->next)++;
+
+  // most gaps fit into one byte
+  if (gap & 0x80) {
+    gap &= 0x7f;
+    for (int shift = 7; ; shift += 7) {
+      uint8_t byte = *(cursor->next)++;
+      gap |= (uint64_t) (byte & 0x7f) << shift;
+      if (!(byte & 0x80)) break;
+    }
+  }
+
+  cursor->id += (TIndex) gap;
+  *id = cursor->id;
+  return 1;
+}
+
+//------------------------------------------------------------------- STREAM
+
+int matchStream(TStream *stream, FILE *f, int passes, double eps);
+void freeStream(TStream *stream);
+void printStream(TStream *stream, FILE *f);
+
+//------------------------------------------------------------------- OUTPUT
+
+#define MATES_MAGIC "EGVM"
+
+int writeMatching(TPool *pool, TGraph *graph, int format, FILE *f);
+void printMatching(TGraph *graph, FILE *f);
+
+//------------------------------------------------------------------- VERIFY
+
+void reachFree(TGraph *graph, TCertificate *cert, int side, uint8_t *reached, TIndex *queue);
+int verifyMatching(TPool *pool, TGraph *graph, TCertificate *cert);
+void freeCertificate(TCertificate *cert);
+void printCertificate(TCertificate *cert, FILE *f);
+
+//------------------------------------------------------------------- DECOMPOSE
+
+int decomposeMatching(TPool *pool, TGraph *graph, TCertificate *cert, TDecomposition *dm);
+void freeDecomposition(TDecomposition *dm);
+int printDecomposition(TDecomposition *dm, FILE *f);
+
+//------------------------------------------------------------------- DYNAMIC
+
+int updateMatching(TPool *pool, TGraph *graph, TUpdate *updates, TIndex n, int *rounds, int *rematched);
+
+#endif
+/* end of file */
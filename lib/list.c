@@ -0,0 +1,107 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ */
+
+#include "internal.h"
+
+//------------------------------------------------------------------- LIST
+
+void initList(TList *L) {
+  L->last = NULL;
+}
+
+int isEmptyList(TList *L) {
+  return (L->last == NULL);
+}
+
+int pushList(TList *L, void *item) {
+
+  TItem *litem = malloc(sizeof(TItem));
+  
+  if (litem == NULL) {
+    return EALLOC;
+  }
+
+  litem->item = item;
+  litem->next = L->last;
+  L->last = litem;
+  
+  return EOK;
+}
+
+void* popList(TList *L) {
+
+  void *item = L->last->item; 
+  
+  TItem *litem = L->last;
+  L->last = litem->next;
+  free(litem);
+  
+  return item;
+}
+
+void freeList(TList *L) {
+  while(!isEmptyList(L)) popList(L);
+}
+
+//------------------------------------------------------------------- QUEUE
+
+void initQueue(TQueue *Q) {
+  Q->first = NULL;
+  Q->last = NULL;
+}
+
+int isEmptyQueue(TQueue *Q) {
+  return (Q->first == NULL);
+}
+
+int pushQueue(TQueue *Q, void *item) {
+  
+  TItem *qitem = malloc(sizeof(TItem));
+  if (qitem == NULL) {
+    return EALLOC;
+  }
+  
+  qitem->item = item;
+  qitem->next = NULL;
+  
+  if (Q->first == NULL) {
+    Q->first = qitem;
+  }
+
+  if (Q->last != NULL) {
+    Q->last->next = qitem;
+  }
+  
+  Q->last = qitem;
+  
+  return EOK;
+}
+
+void* popQueue(TQueue *Q) {
+  
+  if (isEmptyQueue(Q)) {
+    return NULL;
+  }
+  
+  void *item = Q->first->item;
+  
+  TItem *old = Q->first;
+  Q->first = Q->first->next;
+  
+  if (Q->first == NULL) {
+    Q->last = NULL;
+  }
+  
+  free(old);
+  return item;
+}
+
+void freeQueue(TQueue *Q) {
+  while(!isEmptyQueue(Q)) popQueue(Q);
+}
+
+/* end of file */
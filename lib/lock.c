@@ -0,0 +1,88 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Instrumented locks of the parallel search. Built with -DLOCKSTATS
+ * every worker counts acquisitions, contended acquisitions and the time
+ * of waiting per class of locks (nodes, trees, the graph and the queue
+ * of roots) and the pool prints the table of contention when it is
+ * freed. A lock held by another thread is also a span of the trace.
+ */
+
+#define _GNU_SOURCE
+
+#include "internal.h"
+
+static const char *_lockNames[] = {"node", "tree", "graph", "queue"};
+
+//------------------------------------------------------------------- LOCK
+
+void lockCounted(TMutex *mutex, TWorker *worker, int class) {
+
+  if (pthread_mutex_trylock(mutex) == 0) {
+    IFLOCKSTATS(worker->locks[class].acquired++)
+    return;
+  }
+
+  // only a lock held by another thread is timed
+  uint64_t start = traceClock();
+  pthread_mutex_lock(mutex);
+
+  if (worker->trace != NULL) {
+    traceEvent(worker->trace, NODE_WAIT + class, start, -1, 0, 0);
+  }
+
+#ifdef LOCKSTATS
+  TLockStats *locks = &(worker->locks[class]);
+  locks->acquired++;
+  locks->contended++;
+  locks->wait += traceClock() - start;
+#endif
+}
+
+//------------------------------------------------------------------- PRINT
+
+static void _printRow(const char *name, const char *thread, TLockStats *locks, FILE *f) {
+
+  double part = (locks->acquired > 0) ? 100.0 * locks->contended / locks->acquired : 0;
+
+  fprintf(f, "%-6s %6s %14" PRIu64 " %12" PRIu64 " %8.2f%% %12.3f\n", name, thread,
+          locks->acquired, locks->contended, part, locks->wait / 1e6);
+}
+
+//-------------------------------------------------------------------
+
+void printLocks(TPool *pool, FILE *f) {
+
+  // only a library with counted locks has the table
+#ifndef LOCKSTATS
+  return;
+#endif
+
+  fprintf(f, "%-6s %6s %14s %12s %9s %12s\n", "LOCK", "THREAD", "ACQUIRED", "CONTENDED", "PART", "WAIT [ms]");
+
+  for (int c = 0; c < LOCK_CLASSES; c++) {
+
+    TLockStats total = {0, 0, 0};
+    char thread[16];
+
+    // the rows of workers and their sum
+    for (int i = 0; i < pool->n; i++) {
+
+      TLockStats *locks = &(pool->workers[i].locks[c]);
+
+      total.acquired += locks->acquired;
+      total.contended += locks->contended;
+      total.wait += locks->wait;
+
+      snprintf(thread, sizeof(thread), "%d", pool->workers[i].id);
+      _printRow(_lockNames[c], thread, locks, f);
+    }
+
+    _printRow(_lockNames[c], "all", &total, f);
+  }
+}
+
+/* end of file */
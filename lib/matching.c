@@ -0,0 +1,225 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ */
+
+#include "internal.h"
+
+//------------------------------------------------------------------- GRAPH
+
+TGraph *createGraph(TIndex n, TIndex m) {
+
+  if (n < 0 || m < 0) {
+    return NULL;
+  }
+
+  // allocate graph
+  TGraph *graph = malloc(sizeof(TGraph));
+  if (graph == NULL) {
+    return NULL;
+  }
+
+  // init graph
+  if (initGraph(graph, n, m) != EOK) {
+    freeGraph(graph);
+    free(graph);
+    return NULL;
+  }
+
+  return graph;
+}
+
+//-------------------------------------------------------------------
+
+TGraph *createGraphFromArrays(TIndex n, TIndex m, const TIndex *edges) {
+
+  TGraph *graph = createGraph(0, 0);
+  if (graph == NULL) {
+    return NULL;
+  }
+
+  if (setGraphFromArrays(graph, n, m, edges) != EOK) {
+    destroyGraph(graph);
+    return NULL;
+  }
+
+  return graph;
+}
+
+//-------------------------------------------------------------------
+
+int setGraphFromArrays(TGraph *graph, TIndex n, TIndex m, const TIndex *edges) {
+
+  if (n < 0 || m < 0 || (m > 0 && edges == NULL)) {
+    return EPARAM;
+  }
+
+  if (m > EDGES_MAX) {
+    return EINDEX;
+  }
+
+  // reuse buffers of the graph
+  int error = reuseGraph(graph, n, m);
+  if (error != EOK) {
+    return error;
+  }
+
+  // add edges
+  for (TIndex i = 0; i < m && error == EOK; i++) {
+    error = addEdge(graph, edges[2 * (size_t) i], edges[2 * (size_t) i + 1]);
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int readGraph(TGraph *graph, const char *fname) {
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // load graph into the buffers
+  int error = reloadGraph(graph, f);
+  
+  fclose(f);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int readMatching(TGraph *graph, const char *fname) {
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // match the listed edges
+  int error = loadMatching(graph, f);
+
+  fclose(f);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+TIndex getNodes(TGraph *graph) {
+  return graph->n;
+}
+
+TIndex getEdges(TGraph *graph) {
+  return graph->m;
+}
+
+//-------------------------------------------------------------------
+
+void destroyGraph(TGraph *graph) {
+
+  if (graph != NULL) {
+    freeGraph(graph);
+    free(graph);
+  }
+}
+
+//------------------------------------------------------------------- MATCHING
+
+int matchGraph(TGraph *graph, int engine, int threads) {
+
+  if (engine == SEQUENCE) {
+    return findMatchingSequence(graph);
+  }
+  
+  if (engine == PARALLEL && threads > 0) {
+    return findMatching(graph, threads);
+  }
+
+  return EPARAM;
+}
+
+//-------------------------------------------------------------------
+
+void resetMatching(TGraph *graph) {
+
+  for (size_t i = 0; i < 2 * (size_t) graph->used; i++) {
+    graph->edges[i].M = 0;
+  }
+
+  resetSearch(graph);
+}
+
+//-------------------------------------------------------------------
+
+int updateGraph(TGraph *graph, TIndex deletes, const TIndex *deleted,
+                TIndex inserts, const TIndex *inserted, int threads) {
+
+  if (deletes < 0 || inserts < 0 || threads <= 0
+     || (deletes > 0 && deleted == NULL) || (inserts > 0 && inserted == NULL)) {
+    return EPARAM;
+  }
+
+  if (deletes > EDGES_MAX || inserts > EDGES_MAX - deletes) {
+    return EINDEX;
+  }
+
+  // deletes go before inserts
+  TIndex n = deletes + inserts;
+  TUpdate *updates = malloc((size_t) n * sizeof(TUpdate));
+  if (n > 0 && updates == NULL) {
+    return EALLOC;
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    const TIndex *pair = (i < deletes) ? &(deleted[2 * (size_t) i]) : &(inserted[2 * (size_t) (i - deletes)]);
+    updates[i].op = (i < deletes) ? DELETE : INSERT;
+    updates[i].idA = pair[0];
+    updates[i].idB = pair[1];
+  }
+
+  // repair the matching
+  TPool pool;
+  int rounds = 0;
+  int rematched = 0;
+
+  int error = initPool(&pool, threads);
+  if (error == EOK) {
+    error = updateMatching(&pool, graph, updates, n, &rounds, &rematched);
+  }
+
+  freePool(&pool);
+  free(updates);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+TIndex getMates(TGraph *graph, TIndex *mates) {
+
+  TIndex M = 0;
+
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    TNode *node = &(graph->nodes[i]);
+    TEdge *edge = node->edges;
+
+    while((edge != NULL) && !(edge->M)) {
+      edge = edge->next;
+    }
+
+    mates[i] = (edge != NULL) ? edge->node->id : -1;
+    
+    if (edge != NULL && node->id < edge->node->id) {
+      M++;
+    }
+  }
+
+  return M;
+}
+
+/* end of file */
@@ -0,0 +1,108 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Public interface of libmatching. A graph is created with a capacity
+ * of edges, filled from arrays or a file and matched by the chosen
+ * engine. The graph keeps its matching and can be matched, reset or
+ * refilled again without allocating new buffers.
+ *
+ * Node ids and counts are TIndex, 32-bit by default and 64-bit when the
+ * library is built with -DINDEX64 as libmatching64 for graphs with more
+ * than 2^31 nodes or 2^30 edges. Nodes and edges are linked by pointers
+ * in both builds.
+ */
+
+#ifndef MATCHING_H
+#define MATCHING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define MATCHING_API __attribute__((visibility("default")))
+
+#ifdef INDEX64
+typedef int64_t TIndex;
+#else
+typedef int32_t TIndex;
+#endif
+
+//------------------------------------------------------------------- ENUMS
+
+enum errors {
+  EOK = 0,
+  EPARAM,
+  EFILE,
+  EINPUT,
+  EALLOC,
+  EQUEUE,
+  EINTERN,
+  ESOCKET,
+  ELIMIT,
+  EINDEX,
+  EUNKNOWN
+};
+
+enum engines {
+  SEQUENCE = 0,
+  PARALLEL
+};
+
+//------------------------------------------------------------------- TYPES
+
+typedef struct tGraph TGraph;
+
+//------------------------------------------------------------------- GRAPH
+
+// Create a graph with n nodes and space for m edges.
+MATCHING_API TGraph *createGraph(TIndex n, TIndex m);
+
+// Create a graph from m pairs of node ids stored in edges[2*m].
+MATCHING_API TGraph *createGraphFromArrays(TIndex n, TIndex m, const TIndex *edges);
+
+// Replace the content of the graph, reusing its buffers when possible.
+MATCHING_API int setGraphFromArrays(TGraph *graph, TIndex n, TIndex m, const TIndex *edges);
+
+// Replace the content of the graph with a text or binary graph file,
+// EINDEX means the graph needs the 64-bit build.
+MATCHING_API int readGraph(TGraph *graph, const char *fname);
+
+// Seed the matching with pairs "A B" or "(A,B)" of a matching file,
+// such as the output of a previous run.
+MATCHING_API int readMatching(TGraph *graph, const char *fname);
+
+// Add an edge between two nodes, the edge storage grows when it is full.
+MATCHING_API int addEdge(TGraph *graph, TIndex idA, TIndex idB);
+
+MATCHING_API TIndex getNodes(TGraph *graph);
+MATCHING_API TIndex getEdges(TGraph *graph);
+
+MATCHING_API void destroyGraph(TGraph *graph);
+
+//------------------------------------------------------------------- MATCHING
+
+// Extend the current matching of the graph to a maximum one.
+MATCHING_API int matchGraph(TGraph *graph, int engine, int threads);
+
+// Remove all edges from the matching.
+MATCHING_API void resetMatching(TGraph *graph);
+
+// Delete and insert pairs of node ids and repair the maximum matching
+// by searches from the changed nodes only.
+MATCHING_API int updateGraph(TGraph *graph, TIndex deletes, const TIndex *deleted,
+                             TIndex inserts, const TIndex *inserted, int threads);
+
+// Store the mate of each node or -1 into mates[n], return the size of M.
+MATCHING_API TIndex getMates(TGraph *graph, TIndex *mates);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/* end of file */
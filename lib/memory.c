@@ -0,0 +1,151 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ */
+
+#define _GNU_SOURCE
+
+#include <sys/mman.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- MEMORY
+
+const char *backingName(int backing) {
+
+  switch (backing) {
+    case HUGETLB: return "hugetlb";
+    case THP:     return "thp";
+    case PAGES:   return "pages";
+    default:      return "heap";
+  }
+}
+
+//-------------------------------------------------------------------
+
+static void *_mapHugeTLB(size_t size) {
+
+#ifdef MAP_HUGETLB
+  void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+  if (ptr != MAP_FAILED) {
+    return ptr;
+  }
+#else
+  (void) size;
+#endif
+
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static void *_mapAligned(size_t size) {
+
+  // map one extra huge page and trim the region to the alignment
+  size_t length = size + HUGEPAGE_SIZE;
+  char *ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (ptr == MAP_FAILED) {
+    return NULL;
+  }
+
+  uintptr_t addr = (uintptr_t) ptr;
+  uintptr_t aligned = (addr + HUGEPAGE_SIZE - 1) & ~((uintptr_t) HUGEPAGE_SIZE - 1);
+  size_t head = aligned - addr;
+  size_t tail = length - head - size;
+
+  if (head > 0) munmap(ptr, head);
+  if (tail > 0) munmap(ptr + head + size, tail);
+
+  return ptr + head;
+}
+
+//-------------------------------------------------------------------
+
+int allocMemory(TMemory *mem, size_t size) {
+
+  mem->ptr = NULL;
+  mem->size = 0;
+  mem->backing = HEAP;
+
+  if (size == 0) {
+    return EOK;
+  }
+
+  // large regions, rounded up to whole huge pages
+  if (size >= HUGEPAGE_SIZE) {
+
+    size_t length = (size + HUGEPAGE_SIZE - 1) & ~((size_t) HUGEPAGE_SIZE - 1);
+
+    // try the reserved huge pages
+    mem->ptr = _mapHugeTLB(length);
+    if (mem->ptr != NULL) {
+      mem->size = length;
+      mem->backing = HUGETLB;
+      return EOK;
+    }
+
+    // try the transparent huge pages
+    mem->ptr = _mapAligned(length);
+    if (mem->ptr != NULL) {
+      mem->size = length;
+      mem->backing = PAGES;
+
+#ifdef MADV_HUGEPAGE
+      if (madvise(mem->ptr, length, MADV_HUGEPAGE) == 0) {
+        mem->backing = THP;
+      }
+#endif
+      return EOK;
+    }
+  }
+
+  // small regions or no mappings available
+  mem->ptr = malloc(size);
+  if (mem->ptr == NULL) {
+    return EALLOC;
+  }
+
+  mem->size = size;
+  mem->backing = HEAP;
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+void freeMemory(TMemory *mem) {
+
+  if (mem->ptr != NULL) {
+
+    if (mem->backing == HEAP) {
+      free(mem->ptr);
+    }
+    else {
+      munmap(mem->ptr, mem->size);
+    }
+  }
+
+  mem->ptr = NULL;
+  mem->size = 0;
+  mem->backing = HEAP;
+}
+
+//-------------------------------------------------------------------
+
+int resizeMemory(TMemory *mem, size_t size) {
+
+  // keep the region if it is large enough
+  if (mem->ptr != NULL && mem->size >= size) {
+    return EOK;
+  }
+
+  freeMemory(mem);
+  return allocMemory(mem, size);
+}
+
+/* end of file */
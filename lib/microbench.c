@@ -0,0 +1,690 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Microbenchmarks of the primitives of the parallel search, built and
+ * run by make microbench. The engine is included to reach its static
+ * functions. Every benchmark runs the same number of operations in each
+ * thread, the threads start together and the result is the wall time of
+ * one operation from the first start to the last end of a thread, in ns.
+ * Without contention it stays the same for more threads.
+ *
+ * Usage: microbench [THREADS [OPS]]
+ */
+
+#define _GNU_SOURCE
+
+#include <unistd.h>
+
+#include "parallel.c"
+
+#define MICRO_OPS     (1 << 20)
+#define MICRO_THREADS 64
+#define MICRO_PATH    4096
+#define MICRO_NODES   (1 << 17)
+#define MICRO_DEGREE  8
+
+typedef struct tMicro TMicro;
+typedef struct tRunner TRunner;
+
+enum variants {
+  PAIR = 0,
+  GLOBAL,
+  SPIN,
+  TREES
+};
+
+struct tMicro {
+  uint64_t ops;
+  int variant;
+  TIndex hot;
+
+  TNode *nodes;
+  TTree *trees;
+  pthread_spinlock_t *spins;
+  TMutex global;
+  TGraph *graph;
+
+  TCompressed *compressed;
+  uint64_t *offsets;
+  TIndex *neighbours;
+
+  pthread_barrier_t barrier;
+};
+
+struct tRunner {
+  TThread thread;
+  TMicro *micro;
+  TWorker worker;
+  uint64_t seed;
+  uint64_t sink;
+
+  // the own clock of the thread
+  uint64_t start;
+  uint64_t end;
+};
+
+//------------------------------------------------------------------- RUN
+
+static uint64_t _random(TRunner *runner) {
+
+  // xorshift of the thread
+  runner->seed ^= runner->seed << 13;
+  runner->seed ^= runner->seed >> 7;
+  runner->seed ^= runner->seed << 17;
+  return runner->seed;
+}
+
+//-------------------------------------------------------------------
+
+static double _run(TMicro *micro, int threads, void *(*body)(void *)) {
+
+  TRunner runners[MICRO_THREADS];
+  pthread_barrier_init(&(micro->barrier), NULL, threads);
+
+  for (int i = 0; i < threads; i++) {
+
+    memset(&runners[i], 0, sizeof(TRunner));
+    runners[i].micro = micro;
+    runners[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+    runners[i].worker.id = i;
+    runners[i].worker.counters.open = 0;
+
+    pthread_create(&(runners[i].thread), NULL, body, &runners[i]);
+  }
+
+  for (int i = 0; i < threads; i++) {
+    pthread_join(runners[i].thread, NULL);
+  }
+
+  pthread_barrier_destroy(&(micro->barrier));
+
+  // the time runs from the first thread to start to the last to end
+  uint64_t start = runners[0].start, end = runners[0].end;
+
+  for (int i = 1; i < threads; i++) {
+    if (runners[i].start < start) start = runners[i].start;
+    if (runners[i].end > end) end = runners[i].end;
+  }
+
+  return (double) (end - start) / micro->ops;
+}
+
+//-------------------------------------------------------------------
+
+static void _startClock(TRunner *runner) {
+
+  pthread_barrier_wait(&(runner->micro->barrier));
+  runner->start = traceClock();
+}
+
+static void _stopClock(TRunner *runner) {
+  runner->end = traceClock();
+}
+
+//-------------------------------------------------------------------
+
+static void _report(const char *bench, const char *variant, int threads, double ns) {
+  printf("%-10s %-18s %8d %12.2f\n", bench, variant, threads, ns);
+  fflush(stdout);
+}
+
+//------------------------------------------------------------------- NODES
+
+static TNode *_initNodes(TIndex n) {
+
+  TNode *nodes = calloc((size_t) n, sizeof(TNode));
+  if (nodes == NULL) {
+    return NULL;
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    nodes[i].id = i;
+    nodes[i].colour = WHITE;
+    pthread_mutex_init(&(nodes[i].mutex), NULL);
+  }
+
+  return nodes;
+}
+
+//-------------------------------------------------------------------
+
+static void _freeNodes(TNode *nodes, TIndex n) {
+
+  for (TIndex i = 0; i < n; i++) {
+    pthread_mutex_destroy(&(nodes[i].mutex));
+  }
+
+  free(nodes);
+}
+
+//------------------------------------------------------------------- ADD NODE
+
+static void *_addIgnored(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+  TWorker *worker = &(runner->worker);
+
+  // the own root tries the edges to the hot nodes, the edge in M
+  // is ignored after the whole locking of addNodeToTree
+  TEdge edge = {1, NULL, NULL, NULL};
+  TNode *root = &(micro->nodes[micro->hot + worker->id]);
+  TTree *tree = createTree(micro->graph, worker);
+  _addNodeToTree(tree, root, NULL, BLUE);
+
+  _startClock(runner);
+
+  for (uint64_t i = 0; i < micro->ops; i++) {
+    TNode *node = &(micro->nodes[_random(runner) % micro->hot]);
+    runner->sink += addNodeToTree(tree, root, node, &edge, 0, &(worker->stats));
+  }
+
+  _stopClock(runner);
+  freeTree(tree, worker);
+  freeSpareTrees(worker);
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static void *_addPrivate(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+  TWorker *worker = &(runner->worker);
+
+  // the own node joins the own tree and is released again
+  TNode *root = &(micro->nodes[2 * worker->id]);
+  TNode *node = &(micro->nodes[2 * worker->id + 1]);
+  TEdge back = {0, root, NULL, NULL};
+  TEdge edge = {0, node, &back, NULL};
+  back.reversed = &edge;
+
+  TTree *tree = createTree(micro->graph, worker);
+  _addNodeToTree(tree, root, NULL, BLUE);
+
+  _startClock(runner);
+
+  for (uint64_t i = 0; i < micro->ops; i++) {
+
+    runner->sink += addNodeToTree(tree, root, node, &edge, 0, &(worker->stats));
+
+    popList(&(tree->nodes));
+    node->colour = WHITE;
+    node->tree = NULL;
+  }
+
+  _stopClock(runner);
+  freeTree(tree, worker);
+  freeSpareTrees(worker);
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _benchAdd(int *threads, int nthreads, uint64_t ops) {
+
+  TIndex hots[] = {4, 64, 65536};
+  TGraph graph;
+  TMicro micro;
+
+  memset(&micro, 0, sizeof(TMicro));
+  graph.ntree = 0;
+  pthread_mutex_init(&(graph.mutex), NULL);
+
+  micro.ops = ops;
+  micro.graph = &graph;
+  micro.nodes = _initNodes(65536 + 2 * MICRO_THREADS);
+
+  if (micro.nodes == NULL) {
+    return EALLOC;
+  }
+
+  char variant[32];
+
+  for (int t = 0; t < nthreads; t++) {
+    _report("addNode", "private", threads[t], _run(&micro, threads[t], &_addPrivate));
+  }
+
+  for (int h = 0; h < 3; h++) {
+
+    micro.hot = hots[h];
+    snprintf(variant, sizeof(variant), "ignored/hot=%" PRIINDEX, micro.hot);
+
+    for (int t = 0; t < nthreads; t++) {
+      _report("addNode", variant, threads[t], _run(&micro, threads[t], &_addIgnored));
+    }
+  }
+
+  _freeNodes(micro.nodes, 65536 + 2 * MICRO_THREADS);
+  pthread_mutex_destroy(&(graph.mutex));
+  return EOK;
+}
+
+//------------------------------------------------------------------- LOCKS
+
+static void *_lockPairs(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+  TWorker *worker = &(runner->worker);
+
+  // the own tree meets a hot tree as in addNodeToTree
+  TTree own;
+  own.id = micro->hot + worker->id;
+  own.worker = worker;
+  pthread_mutex_init(&(own.mutex), NULL);
+
+  _startClock(runner);
+
+  // two distinct hot objects in the order of ids
+  for (uint64_t i = 0; i < micro->ops; i++) {
+
+    TIndex a = _random(runner) % micro->hot;
+    TIndex b = (a + 1 + _random(runner) % (micro->hot - 1)) % micro->hot;
+
+    switch (micro->variant) {
+
+      case PAIR:
+        lockNodes(&(micro->nodes[a]), &(micro->nodes[b]), worker);
+        micro->nodes[a].depth++;
+        unlockNode(&(micro->nodes[a]));
+        unlockNode(&(micro->nodes[b]));
+        break;
+
+      case GLOBAL:
+        pthread_mutex_lock(&(micro->global));
+        micro->nodes[a].depth++;
+        pthread_mutex_unlock(&(micro->global));
+        break;
+
+      case SPIN:
+        pthread_spin_lock(&(micro->spins[(a < b) ? a : b]));
+        pthread_spin_lock(&(micro->spins[(a < b) ? b : a]));
+        micro->nodes[a].depth++;
+        pthread_spin_unlock(&(micro->spins[a]));
+        pthread_spin_unlock(&(micro->spins[b]));
+        break;
+
+      case TREES:
+        lockTrees(&own, &(micro->trees[a]));
+        micro->trees[a].size++;
+        unlockTree(&(micro->trees[a]));
+        unlockTree(&own);
+        break;
+    }
+  }
+
+  _stopClock(runner);
+
+  pthread_mutex_destroy(&(own.mutex));
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _benchLocks(int *threads, int nthreads, uint64_t ops) {
+
+  const char *names[] = {"lockNodes", "global", "spin", "lockTrees"};
+  TIndex hots[] = {2, 1024};
+  TIndex n = 1024;
+  TMicro micro;
+
+  memset(&micro, 0, sizeof(TMicro));
+  micro.ops = ops;
+  micro.nodes = _initNodes(n);
+  micro.trees = calloc((size_t) n, sizeof(TTree));
+  micro.spins = malloc((size_t) n * sizeof(pthread_spinlock_t));
+
+  if (micro.nodes == NULL || micro.trees == NULL || micro.spins == NULL) {
+    return EALLOC;
+  }
+
+  pthread_mutex_init(&(micro.global), NULL);
+
+  for (TIndex i = 0; i < n; i++) {
+    micro.trees[i].id = i;
+    pthread_mutex_init(&(micro.trees[i].mutex), NULL);
+    pthread_spin_init(&(micro.spins[i]), PTHREAD_PROCESS_PRIVATE);
+  }
+
+  char variant[32];
+
+  for (int v = PAIR; v <= TREES; v++) {
+    for (int h = 0; h < 2; h++) {
+
+      micro.variant = v;
+      micro.hot = hots[h];
+      snprintf(variant, sizeof(variant), "%s/hot=%" PRIINDEX, names[v], micro.hot);
+
+      for (int t = 0; t < nthreads; t++) {
+        _report("lock", variant, threads[t], _run(&micro, threads[t], &_lockPairs));
+      }
+    }
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    pthread_mutex_destroy(&(micro.trees[i].mutex));
+    pthread_spin_destroy(&(micro.spins[i]));
+  }
+
+  pthread_mutex_destroy(&(micro.global));
+  _freeNodes(micro.nodes, n);
+  free(micro.trees);
+  free((void *) micro.spins);
+  return EOK;
+}
+
+//------------------------------------------------------------------- QUEUE
+
+static void *_pushPop(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+
+  TList L;
+  TQueue Q;
+  initList(&L);
+  initQueue(&Q);
+
+  _startClock(runner);
+
+  // one allocation and one free per operation
+  for (uint64_t i = 0; i < micro->ops; i++) {
+
+    switch (micro->variant) {
+
+      case PAIR:
+        pushQueue(&Q, runner);
+        runner->sink += (popQueue(&Q) == runner);
+        break;
+
+      case GLOBAL:
+        pthread_mutex_lock(&(micro->global));
+        pushQueue(&Q, runner);
+        runner->sink += (popQueue(&Q) == runner);
+        pthread_mutex_unlock(&(micro->global));
+        break;
+
+      default:
+        pushList(&L, runner);
+        runner->sink += (popList(&L) == runner);
+    }
+  }
+
+  _stopClock(runner);
+
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _benchQueue(int *threads, int nthreads, uint64_t ops) {
+
+  const char *names[] = {"queue", "queue/locked", "list"};
+  TMicro micro;
+
+  memset(&micro, 0, sizeof(TMicro));
+  micro.ops = ops;
+  pthread_mutex_init(&(micro.global), NULL);
+
+  for (int v = PAIR; v <= SPIN; v++) {
+
+    micro.variant = v;
+
+    for (int t = 0; t < nthreads; t++) {
+      _report("push+pop", names[v], threads[t], _run(&micro, threads[t], &_pushPop));
+    }
+  }
+
+  pthread_mutex_destroy(&(micro.global));
+  return EOK;
+}
+
+//------------------------------------------------------------------- PATH
+
+static void *_flipPath(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+  TIndex n = micro->hot;
+
+  // a path of the thread, every node entered from the previous one
+  TNode *nodes = calloc((size_t) n, sizeof(TNode));
+  TEdge *edges = calloc(2 * (size_t) n, sizeof(TEdge));
+
+  if (nodes != NULL && edges != NULL) {
+
+    for (TIndex i = 1; i < n; i++) {
+
+      TEdge *forward = &edges[2 * i];
+      TEdge *back = &edges[2 * i + 1];
+
+      forward->node = &nodes[i];
+      forward->reversed = back;
+      back->node = &nodes[i - 1];
+      back->reversed = forward;
+      nodes[i].entry = forward;
+    }
+  }
+
+  _startClock(runner);
+
+  // an operation is an edge of a path, the operations are whole paths
+  for (uint64_t i = 0; nodes != NULL && edges != NULL && i < micro->ops; i += n - 1) {
+    processPath(&nodes[n - 1]);
+    runner->sink += edges[2].M;
+  }
+
+  _stopClock(runner);
+
+  free(nodes);
+  free(edges);
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _benchPath(int *threads, int nthreads, uint64_t ops) {
+
+  TIndex lengths[] = {16, MICRO_PATH, 16 * MICRO_PATH};
+  TMicro micro;
+  char variant[32];
+
+  memset(&micro, 0, sizeof(TMicro));
+  micro.ops = ops;
+
+  for (int l = 0; l < 3; l++) {
+
+    micro.hot = lengths[l];
+    micro.ops = (ops / (micro.hot - 1) + 1) * (micro.hot - 1);
+    snprintf(variant, sizeof(variant), "length=%" PRIINDEX, micro.hot - 1);
+
+    for (int t = 0; t < nthreads; t++) {
+      _report("path", variant, threads[t], _run(&micro, threads[t], &_flipPath));
+    }
+  }
+
+  return EOK;
+}
+
+//------------------------------------------------------------------- ADJACENCY
+
+static void *_traverse(void *params) {
+
+  TRunner *runner = params;
+  TMicro *micro = runner->micro;
+  uint64_t count = 0;
+
+  _startClock(runner);
+
+  // an operation is an edge, every thread goes over the whole graph
+  // as many times as the operations are rounded to
+  while (count < micro->ops) {
+
+    TIndex n = micro->graph->n;
+
+    for (TIndex i = 0; i < n; i++) {
+
+      if (micro->variant == PAIR) {
+        for (TEdge *edge = micro->graph->nodes[i].edges; edge != NULL; edge = edge->next) {
+          runner->sink += edge->node->id;
+          count++;
+        }
+      }
+      else if (micro->variant == GLOBAL) {
+        for (uint64_t j = micro->offsets[i]; j < micro->offsets[i + 1]; j++) {
+          runner->sink += micro->neighbours[j];
+          count++;
+        }
+      }
+      else {
+        TCursor cursor;
+        TIndex id;
+        initCursor(&cursor, micro->compressed, i);
+
+        while (nextNeighbour(&cursor, &id)) {
+          runner->sink += id;
+          count++;
+        }
+      }
+    }
+  }
+
+  _stopClock(runner);
+  return NULL;
+}
+
+//-------------------------------------------------------------------
+
+static int _benchAdjacency(int *threads, int nthreads, uint64_t ops) {
+
+  const char *names[] = {"lists", "arrays", "varint"};
+
+  // a random bipartite graph in the text format
+  FILE *f = tmpfile();
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  uint64_t seed = 42;
+  TIndex half = MICRO_NODES / 2;
+  fprintf(f, "%d\n%d\n", MICRO_NODES, MICRO_NODES * MICRO_DEGREE / 2);
+
+  for (int i = 0; i < MICRO_NODES * MICRO_DEGREE / 2; i++) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    fprintf(f, "%" PRIINDEX " %" PRIINDEX "\n", (TIndex) (seed % half), half + (TIndex) ((seed >> 32) % half));
+  }
+
+  TGraph graph;
+  TCompressed compressed;
+  TMicro micro;
+
+  memset(&micro, 0, sizeof(TMicro));
+
+  rewind(f);
+  int error = loadGraph(&graph, f);
+  rewind(f);
+
+  if (error == EOK) {
+    error = loadCompressed(&compressed, f);
+  }
+
+  fclose(f);
+
+  if (error != EOK) {
+    return error;
+  }
+
+  // the lists copied into arrays of neighbours
+  micro.offsets = malloc(((size_t) graph.n + 1) * sizeof(uint64_t));
+  micro.neighbours = malloc(2 * (size_t) graph.m * sizeof(TIndex) + 1);
+
+  if (micro.offsets == NULL || micro.neighbours == NULL) {
+    error = EALLOC;
+  }
+
+  for (TIndex i = 0, j = 0; error == EOK && i < graph.n; i++) {
+
+    micro.offsets[i] = j;
+    for (TEdge *edge = graph.nodes[i].edges; edge != NULL; edge = edge->next) {
+      micro.neighbours[j++] = edge->node->id;
+    }
+
+    micro.offsets[i + 1] = j;
+  }
+
+  micro.graph = &graph;
+  micro.compressed = &compressed;
+
+  for (int v = PAIR; v <= SPIN && error == EOK; v++) {
+
+    micro.variant = v;
+
+    for (int t = 0; t < nthreads; t++) {
+      micro.ops = (ops / (2 * (uint64_t) graph.m) + 1) * 2 * (uint64_t) graph.m;
+      _report("adjacency", names[v], threads[t], _run(&micro, threads[t], &_traverse));
+    }
+  }
+
+  free(micro.offsets);
+  free(micro.neighbours);
+  freeCompressed(&compressed);
+  freeGraph(&graph);
+  return error;
+}
+
+//------------------------------------------------------------------- MAIN
+
+int main(int argc, char *argv[]) {
+
+  int threads[MICRO_THREADS];
+  int nthreads = 0;
+  uint64_t ops = (argc == 3) ? strtoull(argv[2], NULL, 10) : MICRO_OPS;
+
+  // powers of two up to the processors or the given counts
+  if (argc >= 2) {
+    for (char *item = strtok(argv[1], ","); item != NULL && nthreads < MICRO_THREADS; item = strtok(NULL, ",")) {
+      threads[nthreads++] = atoi(item);
+    }
+  }
+  else {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int n = 1; n <= online && nthreads < MICRO_THREADS; n *= 2) {
+      threads[nthreads++] = n;
+    }
+  }
+
+  for (int i = 0; i < nthreads; i++) {
+    if (threads[i] <= 0 || threads[i] > MICRO_THREADS) {
+      fprintf(stderr, "ERROR %d\n", EPARAM);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (argc > 3 || ops == 0) {
+    fprintf(stderr, "ERROR %d\n", EPARAM);
+    return EXIT_FAILURE;
+  }
+
+  printf("%-10s %-18s %8s %12s\n", "BENCH", "VARIANT", "THREADS", "NS/OP");
+
+  int error = _benchAdd(threads, nthreads, ops);
+
+  if (error == EOK) error = _benchLocks(threads, nthreads, ops);
+  if (error == EOK) error = _benchQueue(threads, nthreads, ops);
+  if (error == EOK) error = _benchPath(threads, nthreads, ops);
+  if (error == EOK) error = _benchAdjacency(threads, nthreads, ops);
+
+  if (error != EOK) {
+    fprintf(stderr, "ERROR %d\n", error);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/* end of file */
@@ -0,0 +1,350 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Output of the matching. The text format is written by a large buffer
+ * with its own integer formatting, the binary format is the array of
+ * mates (-1 for free nodes) after a header with magic EGVM and the quiet
+ * format is the size only. With a pool every worker formats a range of
+ * nodes and the chunks are written in order.
+ */
+
+#include <string.h>
+
+#include "internal.h"
+
+#define WRITER_SIZE (1 << 20)
+
+typedef struct tWriter TWriter;
+typedef struct tChunk TChunk;
+
+struct tWriter {
+  FILE *f;
+  char *data;
+  size_t size;
+  size_t used;
+  int error;
+};
+
+struct tChunk {
+  TIndex lo;
+  TIndex hi;
+  TIndex M;
+  int format;
+  TIndex *mates;
+  TWriter writer;
+};
+
+//------------------------------------------------------------------- WRITER
+
+static int _initWriter(TWriter *writer, FILE *f, size_t size) {
+
+  // without a file the writer keeps the text in memory
+  writer->f = f;
+  writer->size = size;
+  writer->used = 0;
+  writer->data = malloc(size);
+  writer->error = (writer->data != NULL) ? EOK : EALLOC;
+  return writer->error;
+}
+
+//-------------------------------------------------------------------
+
+static int _flushWriter(TWriter *writer) {
+
+  if (writer->f != NULL && writer->used > 0 && writer->error == EOK) {
+
+    if (fwrite(writer->data, 1, writer->used, writer->f) != writer->used) {
+      writer->error = EFILE;
+    }
+
+    writer->used = 0;
+  }
+
+  return writer->error;
+}
+
+//-------------------------------------------------------------------
+
+static int _reserveWriter(TWriter *writer, size_t size) {
+
+  if (writer->used + size <= writer->size || writer->error != EOK) {
+    return writer->error;
+  }
+
+  if (writer->f != NULL) {
+    return _flushWriter(writer);
+  }
+
+  // a chunk in memory grows
+  char *data = realloc(writer->data, 2 * writer->size + size);
+  if (data == NULL) {
+    return writer->error = EALLOC;
+  }
+
+  writer->data = data;
+  writer->size = 2 * writer->size + size;
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static char *_formatIndex(char *next, TIndex value) {
+
+  char digits[24];
+  int count = 0;
+
+  do {
+    digits[count++] = '0' + (char) (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  while (count > 0) {
+    *next++ = digits[--count];
+  }
+
+  return next;
+}
+
+//-------------------------------------------------------------------
+
+static void _writeEdge(TWriter *writer, TIndex a, TIndex b) {
+
+  // "(a,b) " of at most 2 * 20 digits
+  if (_reserveWriter(writer, 64) != EOK) {
+    return;
+  }
+
+  char *next = writer->data + writer->used;
+
+  *next++ = '(';
+  next = _formatIndex(next, a);
+  *next++ = ',';
+  next = _formatIndex(next, b);
+  *next++ = ')';
+  *next++ = ' ';
+
+  writer->used = next - writer->data;
+}
+
+//------------------------------------------------------------------- CHUNKS
+
+static int _writeChunk(TJob *job, TWorker *worker) {
+
+  (void) worker;
+
+  TChunk *chunk = job->data;
+  TNode *nodes = job->graph->nodes;
+
+  // the edge of a pair is found from its smaller node
+  for (TIndex i = chunk->lo; i < chunk->hi; i++) {
+
+    if (chunk->mates != NULL) {
+      chunk->mates[i] = -1;
+    }
+
+    for (TEdge *edge = nodes[i].edges; edge != NULL; edge = edge->next) {
+
+      if (!edge->M) continue;
+
+      if (chunk->mates != NULL) {
+        chunk->mates[i] = edge->node->id;
+      }
+
+      if (i < edge->node->id) {
+
+        chunk->M++;
+
+        if (chunk->format == TEXT) {
+          _writeEdge(&(chunk->writer), i, edge->node->id);
+        }
+      }
+    }
+  }
+
+  return chunk->writer.error;
+}
+
+//-------------------------------------------------------------------
+
+static int _writeChunks(TPool *pool, TGraph *graph, int format, TIndex *mates, FILE *f, TIndex *M) {
+
+  int n = (pool != NULL) ? pool->n : 1;
+  int error = EOK;
+
+  TJob *jobs = malloc(n * sizeof(TJob));
+  TChunk *chunks = calloc(n, sizeof(TChunk));
+
+  if (jobs == NULL || chunks == NULL) {
+    free(jobs);
+    free(chunks);
+    return EALLOC;
+  }
+
+  // alone the text goes straight to the file, workers fill memory
+  for (int i = 0; i < n; i++) {
+
+    chunks[i].lo = (TIndex) ((int64_t) graph->n * i / n);
+    chunks[i].hi = (TIndex) ((int64_t) graph->n * (i + 1) / n);
+    chunks[i].format = format;
+    chunks[i].mates = mates;
+
+    if (format == TEXT && error == EOK) {
+      error = _initWriter(&(chunks[i].writer), (pool == NULL) ? f : NULL,
+                          (pool == NULL) ? WRITER_SIZE : WRITER_SIZE / n + 64);
+    }
+
+    jobs[i].task = &_writeChunk;
+    jobs[i].graph = graph;
+    jobs[i].data = &chunks[i];
+    jobs[i].error = EOK;
+    jobs[i].done = 1;
+  }
+
+  for (int i = 0; i < n && error == EOK; i++) {
+
+    if (pool == NULL) {
+      jobs[i].error = _writeChunk(&jobs[i], NULL);
+    }
+    else {
+      error = submitJob(pool, &jobs[i]);
+    }
+  }
+
+  if (pool != NULL) {
+    waitJobs(pool, jobs, n);
+  }
+
+  // the chunks go out in the order of nodes
+  *M = 0;
+
+  for (int i = 0; i < n; i++) {
+
+    if (error == EOK) error = jobs[i].error;
+
+    *M += chunks[i].M;
+    chunks[i].writer.f = f;
+
+    if (format == TEXT && error == EOK) {
+      error = _flushWriter(&(chunks[i].writer));
+    }
+
+    free(chunks[i].writer.data);
+  }
+
+  free(jobs);
+  free(chunks);
+  return error;
+}
+
+//------------------------------------------------------------------- FORMATS
+
+static void _printSections(TGraph *graph, TIndex M, FILE *f) {
+
+  fprintf(f, "<Nodes>\n%" PRIINDEX "\n\n", graph->n);
+  fprintf(f, "<Edges>\n%" PRIINDEX "\n\n", graph->m);
+  fprintf(f, "<Trees>\n%" PRIINDEX "\n\n", graph->ntree);
+
+  // a matching cut short by limits is at least this part of the maximum
+  if (graph->bound >= 0) {
+    fprintf(f, "<Bound>\n%.4f\n\n", graph->bound);
+  }
+
+  fprintf(f, "<Memory>\nnodes %s\nedges %s\n\n",
+          backingName(graph->nodesMemory.backing),
+          backingName(graph->edgesMemory.backing));
+  fprintf(f, "<M>\n%" PRIINDEX "\n", M);
+}
+
+//-------------------------------------------------------------------
+
+static int _writeText(TPool *pool, TGraph *graph, FILE *f) {
+
+  TIndex M = 0;
+  fprintf(f, "<Matching>\n");
+
+  int error = _writeChunks(pool, graph, TEXT, NULL, f, &M);
+  if (error != EOK) {
+    return error;
+  }
+
+  if (M != 0) {
+    fprintf(f, "\n\n");
+  }
+
+  _printSections(graph, M, f);
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static int _writeMates(TPool *pool, TGraph *graph, FILE *f) {
+
+  TIndex M = 0;
+  TIndex *mates = malloc((size_t) graph->n * sizeof(TIndex) + 1);
+
+  if (mates == NULL) {
+    return EALLOC;
+  }
+
+  int error = _writeChunks(pool, graph, BINARY, mates, f, &M);
+
+  // header and one mate per node
+  TBinaryHeader header;
+  memcpy(header.magic, MATES_MAGIC, 4);
+  header.width = sizeof(TIndex);
+  header.n = graph->n;
+  header.m = M;
+
+  if (error == EOK
+     && (fwrite(&header, sizeof(header), 1, f) != 1
+        || fwrite(mates, sizeof(TIndex), (size_t) graph->n, f) != (size_t) graph->n)) {
+    error = EFILE;
+  }
+
+  free(mates);
+  return error;
+}
+
+//------------------------------------------------------------------- WRITE
+
+int writeMatching(TPool *pool, TGraph *graph, int format, FILE *f) {
+
+  TIndex M = 0;
+  int error = EOK;
+
+  switch (format) {
+
+    case TEXT:
+      error = _writeText(pool, graph, f);
+      break;
+
+    case BINARY:
+      error = _writeMates(pool, graph, f);
+      break;
+
+    case QUIET:
+      error = _writeChunks(pool, graph, QUIET, NULL, f, &M);
+      if (error == EOK) fprintf(f, "<M>\n%" PRIINDEX "\n", M);
+      break;
+
+    default:
+      error = EPARAM;
+  }
+
+  if (error == EOK && fflush(f) != 0) {
+    error = EFILE;
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void printMatching(TGraph *graph, FILE *f) {
+  writeMatching(NULL, graph, TEXT, f);
+}
+
+/* end of file */
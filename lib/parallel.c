@@ -0,0 +1,1049 @@
+/*
+ * Project: GAL 2014 - parallel version of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ */
+
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <limits.h>
+#include <string.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- PRINT
+
+void msg(char *format, int id, ...)
+{
+   va_list args;
+   va_start(args, id);
+   fprintf(stderr, "DEBUG[%d] ", id);
+   vfprintf(stderr, format, args);
+   fprintf(stderr, "\n");
+   va_end(args);
+}
+
+void msgt(char *format, TTree *t, ...)
+{
+   va_list args;
+   va_start(args, t);
+   fprintf(stderr, "DEBUG[%d:%" PRIINDEX "] ", t->owner, t->id);
+   vfprintf(stderr, format, args);
+   fprintf(stderr, "\n");
+   va_end(args);
+}
+
+//------------------------------------------------------------------- SYNC
+
+void lockNode(TNode *node) {
+  pthread_mutex_lock(&(node->mutex));
+}
+
+void unlockNode(TNode *node) {
+  pthread_mutex_unlock(&(node->mutex));
+}
+
+static void lockTree(TTree *tree) {
+  lockMutex(&(tree->mutex), tree->worker, TREE_LOCK);
+}
+
+static void unlockTree(TTree *tree) {
+  pthread_mutex_unlock(&(tree->mutex));
+}
+
+static void lockNodes(TNode *nodeA, TNode *nodeB, TWorker *worker) {
+
+  if (nodeA->id < nodeB->id) {
+    lockMutex(&(nodeA->mutex), worker, NODE_LOCK);
+    lockMutex(&(nodeB->mutex), worker, NODE_LOCK);
+  }
+  else {
+    lockMutex(&(nodeB->mutex), worker, NODE_LOCK);
+    lockMutex(&(nodeA->mutex), worker, NODE_LOCK);
+  }
+}
+
+static void lockTrees(TTree *treeA, TTree *treeB) {
+
+  // the owner of tree A waits
+  if (treeA->id < treeB->id) {
+    lockMutex(&(treeA->mutex), treeA->worker, TREE_LOCK);
+    lockMutex(&(treeB->mutex), treeA->worker, TREE_LOCK);
+  }
+  else {
+    lockMutex(&(treeB->mutex), treeA->worker, TREE_LOCK);
+    lockMutex(&(treeA->mutex), treeA->worker, TREE_LOCK);
+  }
+}
+
+//------------------------------------------------------------------- TREE
+
+static TTree *createTree(TGraph *graph, TWorker *worker) {
+
+  TTree *tree = worker->spare;
+
+  // reuse a spare tree of the worker
+  if (tree != NULL) {
+    worker->spare = tree->next;
+  }
+  // allocate tree
+  else {
+    tree = malloc(sizeof(TTree));
+    if (tree == NULL) {
+      return NULL;
+    }
+
+    // init mutex
+    pthread_mutex_init(&(tree->mutex), NULL); 
+  }
+  
+  // init tree
+  tree->status = INPROCESS;
+  tree->root = NULL;
+  tree->owner = worker->id;
+  tree->size = 0;
+  tree->worker = worker;
+  tree->pathEnd = NULL;
+  tree->next = NULL;
+  
+  // init list of nodes
+  initList(&(tree->nodes));
+
+  // critical section
+  lockMutex(&(graph->mutex), worker, GRAPH_LOCK);
+  tree->id = graph->ntree++;    
+  pthread_mutex_unlock(&(graph->mutex));  
+  
+  return tree;
+}
+
+//-------------------------------------------------------------------
+
+static void freeTree(TTree *tree, TWorker *worker) {
+
+  // free list of nodes
+  freeList(&(tree->nodes));
+  
+  // keep the tree for the next root of the worker
+  tree->next = worker->spare;
+  worker->spare = tree;
+}
+
+//-------------------------------------------------------------------
+
+static void freeSpareTrees(TWorker *worker) {
+
+  while (worker->spare != NULL) {
+    TTree *tree = worker->spare;
+    worker->spare = tree->next;
+
+    pthread_mutex_destroy(&(tree->mutex));
+    free(tree);
+  }
+}
+
+//------------------------------------------------------------------- 
+
+void colourNodes(TTree *tree, int colour) {
+  DEBUG(msgt("Colour nodes.", tree))
+
+  TNode *node = NULL;
+  TList *L = &(tree->nodes);
+  
+  while(!isEmptyList(L)) {
+  
+    node = popList(L);  
+    lockMutex(&(node->mutex), tree->worker, NODE_LOCK);
+
+    if (node->tree == tree) {
+      node->colour = colour;
+      node->tree = NULL;
+      node->entry = NULL;
+    }
+    
+    unlockNode(node);
+  }
+}
+
+//------------------------------------------------------------------- MATCHING
+
+int inM(TNode *node) {
+
+  TEdge *edge = node->edges;     
+  while((edge != NULL) && !(edge->M)) {
+    edge = edge->next;
+  }
+  
+  return (edge != NULL);
+}
+
+//------------------------------------------------------------------- 
+
+void changeM(TEdge *edge) {
+
+  edge->M = !(edge->M);
+  edge->reversed->M = !(edge->reversed->M);
+}
+
+//-------------------------------------------------------------------
+
+static void processPath(TNode *end) {
+
+  TNode *u, *v;
+  TEdge *uv, *vu;
+    
+  u = end;
+
+  while (u->entry != NULL) {
+
+    vu = u->entry;
+    uv = vu->reversed;
+    v  = uv->node;
+    
+    changeM(uv);
+    u = v;
+    
+  }
+}
+
+//------------------------------------------------------------------- ADD NODE TO TREE
+
+static void _addNodeToTree(TTree *tree, TNode *node, TEdge *edge, int colour) {
+  
+  node->tree = tree;
+  node->entry = edge;
+  node->colour = colour;
+  node->depth = (edge != NULL) ? edge->reversed->node->depth + 1 : 0;
+  
+  pushList(&(tree->nodes), node);
+}
+
+//-------------------------------------------------------------------
+
+
+static int addNodeToTree(TTree *treeA, TNode *nodeA, TNode *nodeB, TEdge *AB, int M, TStats *stats) {
+
+  DEBUG(msgt("Try add node B %" PRIINDEX " to node A %" PRIINDEX ".", treeA, nodeB->id, nodeA->id))
+
+  // init
+  int status = OK;
+  int hasPath = 0;
+  int colour = M ? RED : BLUE;  
+  
+  TTree *treeB = NULL;
+  
+  // lock nodes
+  lockNodes(nodeA, nodeB, treeA->worker);
+    
+  // lock tree A and check if it has path
+  lockTree(treeA);
+  hasPath = (treeA->status == HASPATH);
+  unlockTree(treeA);
+  
+  // has path
+  if(hasPath) {
+    DEBUG(msgt("PATH: Has path.", treeA))
+    status = PATH;
+  }
+  // same trees
+  else if (nodeA->tree == nodeB->tree) {
+    DEBUG(msgt("IGNORE: Same trees.", treeA))
+    status = IGNORE;
+  }
+  // check matching
+  else if (AB->M != M) {
+    DEBUG(msgt("IGNORE: Wrong type of edge.", treeA))
+    status = IGNORE;  
+  }
+  // APS tree
+  else if (nodeB->colour == GREEN) {
+    DEBUG(msgt("IGNORE: The node %" PRIINDEX " is in APS tree.", treeA, nodeB->id))
+    status = IGNORE;   
+  }
+  // FREE tree
+  else if (nodeB->colour == WHITE) {
+    DEBUG(msgt("OK: The node %" PRIINDEX " is free.", treeA, nodeB->id))
+    
+    lockTree(treeA);
+    _addNodeToTree(treeA, nodeB, AB, colour);
+    unlockTree(treeA);
+    
+    status = OK; 
+  }
+  // INPROCESS tree - found path
+  else if (nodeB->colour == nodeA->colour) {
+      
+    treeB = nodeB->tree;
+    lockTrees(treeA, treeB);
+    
+    if (treeA->status == INPROCESS && treeB->status == INPROCESS) {
+      DEBUG(msgt("PATH: Found path.", treeA))
+      
+      treeA->status = HASPATH;
+      treeA->pathEnd = nodeA;  
+      treeB->status = HASPATH;
+      treeB->pathEnd = nodeB;
+      changeM(AB);
+      status = PATH;
+
+      // the path goes through both trees
+      countStat(stats->paths, nodeA->depth + nodeB->depth + 1);
+      stats->augmentations++;
+    }
+    else {
+      DEBUG(msgt("IGNORE: Tree A is in conflict.", treeA))
+      status = CONFLICT;
+    }
+    
+    unlockTree(treeA);
+    unlockTree(treeB);
+  
+  }
+  // INPROCESS tree - conflict
+  else {
+    DEBUG(msgt("IGNORE: Tree A is in conflict.", treeA))
+    status = CONFLICT;      
+  }
+  
+  unlockNode(nodeA);
+  unlockNode(nodeB);
+
+  stats->edges++;
+  stats->outcomes[status]++;
+
+  DEBUG(msgt("End of add node to tree.", treeA))
+  return status;
+}
+
+//------------------------------------------------------------------- APPLY APS
+
+static int _applyAPS(TTree *tree, TQueue *Q, const TLimits *limits, TStats *stats, int *ptrStatus) {
+
+  DEBUG(msgt("Apply APS for root %" PRIINDEX ".", tree, tree->root->id))
+
+  int M = 0; 
+  int error = EOK; 
+  int status = OK;
+  int colour = WHITE;
+  int conflicts = 0;
+  int cuts = 0;
+  int late = 0;
+  uint64_t size = 1;
+
+  // paths longer than the limit are not searched
+  const struct timespec *deadline = (limits != NULL && limits->cancel) ? limits->deadline : NULL;
+  int length = (limits != NULL && limits->length > 0) ? limits->length : INT_MAX;
+  
+  TNode *x, *y, *z, *pathEnd = NULL;
+  TEdge *xy, *yz;
+
+  // insert root into Q
+  error = pushQueue(Q, (void*) tree->root);
+  
+  if (error != EOK)
+    return error;
+  
+  // process the queue, a tree in conflict can not be an APS tree and stops
+  while(!isEmptyQueue(Q) && status == OK && error == EOK && !conflicts) {
+
+    // get x
+    x = popQueue(Q);    
+    xy = x->edges;
+
+    // give the tree up after the deadline
+    if (isLate(deadline)) {
+      late = 1;
+      break;
+    }
+
+    // paths through x would be too long
+    if (x->depth + 1 > length) {
+      cuts++;
+      continue;
+    }
+    
+    while(xy != NULL && status == OK && error == EOK && !conflicts) {
+
+      // get y
+      y = xy->node;
+      status = addNodeToTree(tree, x, y, xy, 0, stats);
+      
+      // try next edge
+      if (status == IGNORE || status == CONFLICT) {
+        conflicts += (status == CONFLICT);
+        xy = xy->next;
+        status = OK;
+      }      
+      // new y
+      else if (status == OK) {
+        DEBUG(msgt("Added new y=%" PRIINDEX ".", tree, y->id));      
+        
+        size++;
+        M = 0;      
+        yz = y->edges;
+      
+        while(yz != NULL && status == OK && error == EOK) {
+            
+          // get z
+          z = yz->node;
+          status = addNodeToTree(tree, y, z, yz, 1, stats);
+
+          // try next edge
+          if (status == IGNORE) {
+            yz = yz->next;
+            status = OK;
+          }
+          // node in conflict, try next y
+          else if (status == CONFLICT) {
+            conflicts++;
+            status = OK;
+            yz = NULL;
+            M++;
+          }
+          // new z
+          else if (status == OK) {
+            DEBUG(msgt("Added new z=%" PRIINDEX ".", tree, z->id));
+            
+            error = pushQueue(Q, (void*) z);
+            size++;
+            M++;
+            break;
+          }
+        }    
+      
+        // found path from y
+        if (status == OK && !M) {  
+          DEBUG(msgt("Found path, y is not in M.", tree))
+          pathEnd = y;
+          status = PATH;
+        }
+      
+        // try next edge xy
+        xy = xy->next;      
+      }
+    }
+  }
+
+  // process results  
+  lockTree(tree);
+  
+  if (status == PATH) {
+    DEBUG(msgt("Processing path.", tree))
+    
+    if (tree->status == HASPATH) {
+      pathEnd = tree->pathEnd;
+    }
+    else {
+      countStat(stats->paths, pathEnd->depth);
+      stats->augmentations++;
+    }
+
+    tree->status = HASPATH;
+    unlockTree(tree);
+    
+    processPath(pathEnd);
+    colour = WHITE;
+    status = OK;
+  }
+  else if (late) {
+
+    // the root waits in the queue after the deadline
+    DEBUG(msgt("Tree was late.", tree))
+    tree->status = FREE;
+    colour = WHITE;
+    status = ABORT;
+
+    unlockTree(tree);
+  }
+  else if (conflicts > 0) {
+
+    // other trees hid a part of the tree, the root is deferred
+    DEBUG(msgt("Tree was in conflict.", tree))
+    tree->status = FREE;
+    colour = WHITE;
+    status = CONFLICT;
+
+    unlockTree(tree);
+  }
+  else if (cuts > 0) {
+
+    // longer paths may exist, the nodes stay free for other trees
+    DEBUG(msgt("Tree was cut.", tree))
+    tree->status = FREE;
+    colour = WHITE;
+    status = OK;
+
+    unlockTree(tree);
+  }
+  else {
+    
+    DEBUG(msgt("Found APS tree.", tree))
+    tree->status = APSTREE;
+    colour = GREEN;
+    status = OK;
+       
+    unlockTree(tree);
+    stats->apsTrees++;
+  }
+
+  countStat(stats->sizes, size);
+  tree->size = size;
+
+  // recolour nodes
+  colourNodes(tree, colour);
+  
+  // set status
+  *ptrStatus = status;
+  
+  DEBUG(msgt("End of apply APS.", tree))
+  return error;
+}
+
+static int applyAPS(TTree *tree, const TLimits *limits, TStats *stats, int *status) {
+
+  TQueue Q;
+  initQueue(&Q);
+    
+  int error = _applyAPS(tree, &Q, limits, stats, status);
+
+  freeQueue(&Q);
+  return error;
+}
+
+//------------------------------------------------------------------- FIND MATCHING
+
+int isLate(const struct timespec *deadline) {
+
+  if (deadline == NULL) {
+    return 0;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec > deadline->tv_sec)
+      || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+void initDeadline(struct timespec *deadline, double seconds) {
+
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+
+  long nsec = deadline->tv_nsec + (long) ((seconds - (long) seconds) * 1e9);
+  deadline->tv_sec += (long) seconds + nsec / 1000000000L;
+  deadline->tv_nsec = nsec % 1000000000L;
+}
+
+//-------------------------------------------------------------------
+
+static int _findMatching(TGraph *graph, TQueue *Q, TQueue *deferred, TMutex *qmutex, const TLimits *limits, TWorker *worker) {
+
+  int error = EOK;
+  int status = OK;
+  const struct timespec *deadline = (limits != NULL) ? limits->deadline : NULL;
+  
+  while(error == EOK) {
+    
+    // lock the queue
+    DEBUG(msg("Get new root node.", worker->id))
+    lockMutex(qmutex, worker, QUEUE_LOCK);
+    
+    // is queue empty? the rest of roots waits after the deadline
+    if(isEmptyQueue(Q) || isLate(deadline)) {
+      DEBUG(msg("Root node queue is empty.", worker->id))
+      pthread_mutex_unlock(qmutex);
+      break;
+    }
+    
+    else {
+    
+      // get root node
+      TNode *node = popQueue(Q);
+      
+      // unlock the queue
+      pthread_mutex_unlock(qmutex);
+      
+      // lock the node
+      lockMutex(&(node->mutex), worker, NODE_LOCK);
+
+      if (node->colour == WHITE) {
+        if (!inM(node)) {
+        
+          // create tree
+          uint64_t start = (worker->trace != NULL) ? traceClock() : 0;
+          TTree *tree = createTree(graph, worker);
+          if (tree == NULL) {
+            unlockNode(node);
+            return EALLOC;
+          }
+
+          worker->stats.trees++;
+          
+          // lock the tree
+          lockTree(tree);
+      
+          tree->root = node; 
+          
+          _addNodeToTree(tree, node, NULL, RED);
+          
+          // unlock the tree     
+          unlockTree(tree);
+          
+          // unlock the node
+          unlockNode(node);
+      
+          // find augmenting path
+          error = applyAPS(tree, limits, &(worker->stats), &status);      
+
+          if (worker->trace != NULL) {
+            int end = (tree->status == HASPATH) ? AUGMENTED : (tree->status == APSTREE) ? HUNGARIAN
+                    : (status == ABORT || status == CONFLICT) ? ABORTED : CUT;
+            traceEvent(worker->trace, TREE_SPAN, start, node->id, end, tree->size);
+          }
+          
+          // free nodes in tree and tree     
+          freeTree(tree, worker);     
+        }
+        else {
+          DEBUG(msg("Root node %" PRIINDEX " in M.", worker->id, node->id))
+          unlockNode(node);        
+          status = OK;
+        }
+      }
+      else if (node->colour == GREEN) {
+        DEBUG(msg("Root node %" PRIINDEX " in APS tree.", worker->id, node->id))
+        unlockNode(node);
+        status = OK;
+      }
+      else {
+        DEBUG(msg("Root node %" PRIINDEX " is processed.", worker->id, node->id))
+        unlockNode(node);
+        status = ABORT;
+
+        if (worker->trace != NULL) {
+          traceEvent(worker->trace, REQUEUE, traceClock(), node->id, 0, 0);
+        }
+      }
+
+      // return node to queue
+      if (status == ABORT) {
+        DEBUG(msg("Return node %" PRIINDEX " to root node queue.", worker->id, node->id))
+        lockMutex(qmutex, worker, QUEUE_LOCK);
+        error = pushQueue(Q, (void*) node);
+        pthread_mutex_unlock(qmutex);
+
+        worker->stats.aborts++;
+      }
+      // retried only after the queue drains, conflicting roots would hide each other again
+      else if (status == CONFLICT) {
+        DEBUG(msg("Defer node %" PRIINDEX ".", worker->id, node->id))
+        lockMutex(qmutex, worker, QUEUE_LOCK);
+        error = pushQueue(deferred, (void*) node);
+        pthread_mutex_unlock(qmutex);
+
+        worker->stats.aborts++;
+      }
+    }  
+  }
+
+  return error;
+}
+
+//------------------------------------------------------------------- POOL
+
+static void *_runWorker(void *params) {
+
+  TWorker *worker = (TWorker*) params;
+  TPool *pool = worker->pool;
+  TJob *job = NULL;
+
+  while(1) {
+
+    // wait for a job
+    pthread_mutex_lock(&(pool->mutex));
+
+    while(isEmptyQueue(&(pool->jobs)) && !pool->stop) {
+      pthread_cond_wait(&(pool->work), &(pool->mutex));
+    }
+
+    if (isEmptyQueue(&(pool->jobs))) {
+      pthread_mutex_unlock(&(pool->mutex));
+      break;
+    }
+
+    job = popQueue(&(pool->jobs));
+
+    // counters of the thread from its first counted job, published
+    // under the mutex for the samples of the main thread
+    if (pool->counting && !worker->counters.open) {
+      openCounters(&(worker->counters));
+    }
+
+    pthread_mutex_unlock(&(pool->mutex));
+
+    // run the job
+    job->error = job->task(job, worker);
+
+    if (job->error != EOK) {
+      fprintf(stderr, "ERROR %d\n", job->error);
+    }
+
+    // report the finished job
+    pthread_mutex_lock(&(pool->mutex));
+
+    job->done = 1;
+    pool->pending--;
+    pthread_cond_broadcast(&(pool->done));
+
+    pthread_mutex_unlock(&(pool->mutex));
+  }
+
+  freeSpareTrees(worker);
+  pthread_exit(0);
+}
+
+//-------------------------------------------------------------------
+
+int initPool(TPool *pool, int n) {
+
+  // init pool
+  pool->n = 0;
+  pool->pending = 0;
+  pool->stop = 0;
+  pool->counting = 0;
+
+  // a pool that failed to init can still be freed
+  initQueue(&(pool->jobs));
+  pthread_mutex_init(&(pool->mutex), NULL);
+  pthread_cond_init(&(pool->work), NULL);
+  pthread_cond_init(&(pool->done), NULL);
+
+  pool->workers = malloc(n * sizeof(TWorker));
+
+  if (pool->workers == NULL) {
+    return EALLOC;
+  }
+
+  // start workers
+  for (int i = 0; i < n; i++) {
+
+    TWorker *worker = &(pool->workers[i]);
+    worker->id = i + 1;
+    worker->pool = pool;
+    worker->spare = NULL;
+    worker->trace = NULL;
+    worker->counters.open = 0;
+    for (int j = 0; j < PERF_EVENTS; j++) worker->counters.fds[j] = -1;
+    memset(&(worker->stats), 0, sizeof(TStats));
+    memset(worker->locks, 0, sizeof(worker->locks));
+
+    if (pthread_create(&(worker->thread), NULL, &_runWorker, (void *) worker) != 0) {
+      break;
+    }
+
+    pool->n++;
+  }
+
+  return (pool->n > 0) ? EOK : EINTERN;
+}
+
+//-------------------------------------------------------------------
+
+int submitJob(TPool *pool, TJob *job) {
+
+  pthread_mutex_lock(&(pool->mutex));
+  job->done = 0;
+  int error = pushQueue(&(pool->jobs), (void*) job);
+
+  if (error == EOK) {
+    pool->pending++;
+    pthread_cond_signal(&(pool->work));
+  }
+
+  pthread_mutex_unlock(&(pool->mutex));
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void waitPool(TPool *pool) {
+
+  pthread_mutex_lock(&(pool->mutex));
+
+  while(pool->pending > 0) {
+    pthread_cond_wait(&(pool->done), &(pool->mutex));
+  }
+
+  pthread_mutex_unlock(&(pool->mutex));
+}
+
+//-------------------------------------------------------------------
+
+void waitJobs(TPool *pool, TJob *jobs, int n) {
+
+  pthread_mutex_lock(&(pool->mutex));
+
+  for (int i = 0; i < n; i++) {
+    while(!jobs[i].done) {
+      pthread_cond_wait(&(pool->done), &(pool->mutex));
+    }
+  }
+
+  pthread_mutex_unlock(&(pool->mutex));
+}
+
+//-------------------------------------------------------------------
+
+void freePool(TPool *pool) {
+
+  // stop workers
+  pthread_mutex_lock(&(pool->mutex));
+  pool->stop = 1;
+  pthread_cond_broadcast(&(pool->work));
+  pthread_mutex_unlock(&(pool->mutex));
+
+  for (int i = 0; i < pool->n; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+
+  // free pool
+  freeTrace(pool);
+
+  for (int i = 0; i < pool->n; i++) {
+    if (pool->workers[i].counters.open) closeCounters(&(pool->workers[i].counters));
+  }
+
+  freeQueue(&(pool->jobs));
+  pthread_mutex_destroy(&(pool->mutex));
+  pthread_cond_destroy(&(pool->work));
+  pthread_cond_destroy(&(pool->done));
+  free(pool->workers);
+}
+
+//------------------------------------------------------------------- FIND MATCHING IN POOL
+
+int initRoots(TGraph *graph, TQueue *Q) {
+
+  initQueue(Q);
+
+  for (TIndex i = 0; i < graph->n; i++) {
+    int error = pushQueue(Q, (void*) &(graph->nodes[i]));
+
+    if (error != EOK) {
+      freeQueue(Q);
+      return error;
+    }
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static int _findMatchingShared(TJob *job, TWorker *worker) {
+  return _findMatching(job->graph, job->queue, job->deferred, job->mutex, job->data, worker);
+}
+
+//-------------------------------------------------------------------
+
+int _findMatchingAlone(TJob *job, TWorker *worker) {
+
+  // the worker owns the whole graph
+  TQueue Q;
+  TMutex qmutex;
+  
+  resetSearch(job->graph);
+  int error = initRoots(job->graph, &Q);
+  if (error != EOK) {
+    return error;
+  }
+
+  pthread_mutex_init(&qmutex, NULL);
+  error = _findMatching(job->graph, &Q, &Q, &qmutex, NULL, worker);
+  pthread_mutex_destroy(&qmutex);
+  
+  freeQueue(&Q);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int runRoots(TPool *pool, TGraph *graph, TQueue *Q, const TLimits *limits) {
+
+  int error = EOK;
+  
+  // init jobs
+  TJob *jobs = malloc(pool->n * sizeof(TJob));
+  if (jobs == NULL) {
+    return EALLOC;
+  }
+  
+  TMutex qmutex;
+  pthread_mutex_init(&(qmutex), NULL);
+
+  TQueue deferred;
+  initQueue(&deferred);
+  
+  // all workers share the queue of roots
+  for (int i = 0; i < pool->n; i++) {
+
+    jobs[i].task = &_findMatchingShared;
+    jobs[i].graph = graph;
+    jobs[i].queue = Q;
+    jobs[i].deferred = &deferred;
+    jobs[i].mutex = &qmutex;
+    jobs[i].data = (void*) limits;
+    jobs[i].error = EOK;  
+    jobs[i].done = 1;
+    
+    if (error == EOK) {
+      error = submitJob(pool, &jobs[i]);
+    }
+  }
+
+  // wait for workers
+  waitJobs(pool, jobs, pool->n);
+
+  for (int i = 0; i < pool->n; i++) {
+    if(error == EOK) error = jobs[i].error;
+  }
+
+  // one worker finishes the deferred roots, alone it meets no other tree
+  while (error == EOK && !isEmptyQueue(&deferred)) {
+    error = pushQueue(Q, popQueue(&deferred));
+  }
+
+  if (error == EOK && !isEmptyQueue(Q) && pool->n > 1) {
+
+    jobs[0].deferred = Q;
+    jobs[0].error = EOK;
+    jobs[0].done = 1;
+
+    error = submitJob(pool, &jobs[0]);
+    if (error == EOK) {
+      waitJobs(pool, jobs, 1);
+      error = jobs[0].error;
+    }
+  }
+
+  freeQueue(&deferred);
+  pthread_mutex_destroy(&(qmutex));
+  free(jobs);  
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int findMatchingInPool(TPool *pool, TGraph *graph) {
+
+  // init queue
+  TQueue Q;
+  resetSearch(graph);
+  int error = initRoots(graph, &Q);
+  if (error != EOK) {
+    return error;
+  }
+  
+  error = runRoots(pool, graph, &Q, NULL);
+
+  freeQueue(&Q);
+  return error;
+}
+
+//------------------------------------------------------------------- BOUNDED MATCHING
+
+double qualityBound(TIndex M, TIndex free, int length) {
+
+  // augmenting paths end in two free nodes outside of APS trees
+  double bound = (M + free / 2 > 0) ? (double) M / (M + free / 2) : 1;
+
+  // without paths of 2j - 1 edges the matching has j / (j + 1) of the maximum
+  if (length > 0) {
+    int j = (length + 1) / 2;
+    double part = (double) j / (j + 1);
+    if (part > bound) bound = part;
+  }
+
+  return bound;
+}
+
+//-------------------------------------------------------------------
+
+static void _countMatching(TGraph *graph, TIndex *M, TIndex *free) {
+
+  *M = 0;
+  *free = 0;
+
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    TNode *node = &(graph->nodes[i]);
+
+    if (inM(node)) {
+      (*M)++;
+    }
+    else if (node->colour != GREEN) {
+      (*free)++;
+    }
+  }
+
+  *M /= 2;
+}
+
+//-------------------------------------------------------------------
+
+int findMatchingBounded(TPool *pool, TGraph *graph, const TLimits *limits) {
+
+  TQueue Q;
+  TIndex M = -1, size = 0, free = 0;
+  int proven = 0;
+  int error = EOK;
+
+  resetSearch(graph);
+
+  // cut trees may get short paths from later augmentations,
+  // sweep the roots again until a sweep changes nothing
+  while (error == EOK) {
+
+    error = initRoots(graph, &Q);
+    if (error != EOK) {
+      return error;
+    }
+
+    error = runRoots(pool, graph, &Q, limits);
+
+    int complete = isEmptyQueue(&Q);
+    freeQueue(&Q);
+
+    _countMatching(graph, &size, &free);
+
+    if (!complete || free == 0) break;
+    if (size == M) {
+      proven = 1;
+      break;
+    }
+
+    M = size;
+  }
+
+  graph->bound = qualityBound(size, free, proven ? limits->length : 0);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int findMatching(TGraph *graph, int n) {
+
+  TPool pool;
+  
+  int error = initPool(&pool, n);
+  if (error == EOK) {
+    error = findMatchingInPool(&pool, graph);
+  }
+  
+  freePool(&pool);
+  return error;
+}
+
+/* end of file */
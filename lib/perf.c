@@ -0,0 +1,260 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Hardware counters of the phases of a run. Every thread opens its own
+ * perf events for cycles, instructions, misses of the last level cache
+ * and the data TLB and mispredicted branches, the workers of a pool when
+ * they start their first job. A phase is the difference of the sums over
+ * all threads. Counters the kernel does not permit are not available and
+ * the report keeps the time, the CPU time, page faults and context
+ * switches of the process.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <linux/perf_event.h>
+
+#include "internal.h"
+
+static const char *_counterNames[] = {"cycles", "instructions", "llc-misses", "dtlb-misses", "branch-misses"};
+static const char *_stageNames[] = {"LOAD", "MATCH", "OUTPUT"};
+
+//------------------------------------------------------------------- COUNTERS
+
+static int _openEvent(uint32_t type, uint64_t config) {
+
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  // the calling thread on any cpu
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+//-------------------------------------------------------------------
+
+void openCounters(TCounters *counters) {
+
+  counters->open = 1;
+  uint64_t cache = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+
+  counters->fds[0] = _openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  counters->fds[1] = _openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  counters->fds[2] = _openEvent(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cache);
+  counters->fds[3] = _openEvent(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | cache);
+  counters->fds[4] = _openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+}
+
+//-------------------------------------------------------------------
+
+void closeCounters(TCounters *counters) {
+
+  counters->open = 0;
+
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    if (counters->fds[i] >= 0) close(counters->fds[i]);
+    counters->fds[i] = -1;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static void _readCounters(TCounters *counters, uint64_t *values) {
+
+  for (int i = 0; i < PERF_EVENTS; i++) {
+
+    uint64_t value = 0;
+
+    if (counters->fds[i] >= 0 && read(counters->fds[i], &value, sizeof(value)) == sizeof(value)) {
+      values[i] += value;
+    }
+  }
+}
+
+//------------------------------------------------------------------- PHASES
+
+static void _sample(TPerf *perf, TPool *pool, TSample *sample) {
+
+  memset(sample, 0, sizeof(TSample));
+
+  // counters of all threads
+  _readCounters(&(perf->main), sample->values);
+
+  // workers open theirs under the mutex of the pool
+  if (pool != NULL) {
+
+    pthread_mutex_lock(&(pool->mutex));
+
+    for (int i = 0; i < pool->n; i++) {
+      if (pool->workers[i].counters.open) {
+        _readCounters(&(pool->workers[i].counters), sample->values);
+      }
+    }
+
+    pthread_mutex_unlock(&(pool->mutex));
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  sample->time = traceClock();
+  sample->cpu = (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL
+              + (uint64_t) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+  sample->faults = usage.ru_minflt + usage.ru_majflt;
+  sample->switches = usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+//-------------------------------------------------------------------
+
+void initPerf(TPerf *perf) {
+
+  memset(perf, 0, sizeof(TPerf));
+  openCounters(&(perf->main));
+}
+
+//-------------------------------------------------------------------
+
+void beginPerf(TPerf *perf, TPool *pool) {
+
+  // workers count from their first job
+  if (pool != NULL) {
+    pthread_mutex_lock(&(pool->mutex));
+    pool->counting = 1;
+    pthread_mutex_unlock(&(pool->mutex));
+  }
+
+  _sample(perf, pool, &(perf->start));
+}
+
+//-------------------------------------------------------------------
+
+void endPerf(TPerf *perf, TPool *pool, int stage, uint64_t edges) {
+
+  TSample end;
+  _sample(perf, pool, &end);
+
+  TSample *phase = &(perf->stages[stage]);
+
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    phase->values[i] = end.values[i] - perf->start.values[i];
+  }
+
+  phase->time = end.time - perf->start.time;
+  phase->cpu = end.cpu - perf->start.cpu;
+  phase->faults = end.faults - perf->start.faults;
+  phase->switches = end.switches - perf->start.switches;
+  phase->edges = edges;
+  phase->done = 1;
+}
+
+//-------------------------------------------------------------------
+
+void freePerf(TPerf *perf) {
+  closeCounters(&(perf->main));
+}
+
+//------------------------------------------------------------------- PRINT
+
+static void _printRow(TPerf *perf, const char *name, int counter, FILE *f) {
+
+  fprintf(f, "%-16s", name);
+
+  for (int s = 0; s < PERF_STAGES; s++) {
+
+    TSample *phase = &(perf->stages[s]);
+
+    if (!phase->done) {
+      fprintf(f, " %14s", "-");
+    }
+    else if (counter < 0) {
+      fprintf(f, " %14" PRIu64, phase->edges);
+    }
+    else if (perf->main.fds[counter] < 0) {
+      fprintf(f, " %14s", "n/a");
+    }
+    else {
+      fprintf(f, " %14" PRIu64, phase->values[counter]);
+    }
+  }
+
+  fprintf(f, "\n");
+
+  if (counter < 0 || perf->main.fds[counter] < 0) {
+    return;
+  }
+
+  // normalized per edge
+  fprintf(f, "%-16s", "  per edge");
+
+  for (int s = 0; s < PERF_STAGES; s++) {
+
+    TSample *phase = &(perf->stages[s]);
+
+    if (phase->done && phase->edges > 0) {
+      fprintf(f, " %14.3f", (double) phase->values[counter] / phase->edges);
+    }
+    else {
+      fprintf(f, " %14s", "-");
+    }
+  }
+
+  fprintf(f, "\n");
+}
+
+//-------------------------------------------------------------------
+
+void printPerf(TPerf *perf, FILE *f) {
+
+  fprintf(f, "%-16s", "COUNTER");
+  for (int s = 0; s < PERF_STAGES; s++) {
+    fprintf(f, " %14s", _stageNames[s]);
+  }
+  fprintf(f, "\n");
+
+  _printRow(perf, "edges", -1, f);
+
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    _printRow(perf, _counterNames[i], i, f);
+  }
+
+  // always available
+  fprintf(f, "%-16s", "time [ms]");
+  for (int s = 0; s < PERF_STAGES; s++) {
+    fprintf(f, " %14.3f", perf->stages[s].time / 1e6);
+  }
+
+  fprintf(f, "\n%-16s", "cpu [ms]");
+  for (int s = 0; s < PERF_STAGES; s++) {
+    fprintf(f, " %14.3f", perf->stages[s].cpu / 1e6);
+  }
+
+  fprintf(f, "\n%-16s", "faults");
+  for (int s = 0; s < PERF_STAGES; s++) {
+    fprintf(f, " %14ld", perf->stages[s].faults);
+  }
+
+  fprintf(f, "\n%-16s", "switches");
+  for (int s = 0; s < PERF_STAGES; s++) {
+    fprintf(f, " %14ld", perf->stages[s].switches);
+  }
+
+  fprintf(f, "\n");
+
+  if (perf->main.fds[0] < 0) {
+    fprintf(f, "perf events are not permitted, see /proc/sys/kernel/perf_event_paranoid\n");
+  }
+}
+
+/* end of file */
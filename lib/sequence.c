@@ -0,0 +1,300 @@
+/*
+ * Project: GAL 2014 - sequence version of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni07
+ * Date:    13.11.2014
+ */
+
+#include <limits.h>
+
+#include "internal.h"
+
+#undef DEBUG
+#define DEBUG(x)   //fprintf(stderr, "DEBUG: " x "\n");
+
+//------------------------------------------------------------------- TREE
+
+static TTree *createTree(TTree **trees) {
+
+  // allocate tree
+  TTree *tree = malloc(sizeof(TTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  
+  // init tree
+  tree->status = INPROCESS;
+  tree->root = NULL;
+  tree->next = *trees;
+  *trees = tree;
+  
+  return tree;
+}
+
+//-------------------------------------------------------------------
+
+static void freeTrees(TTree **trees) {
+
+  while(*trees != NULL) {
+    TTree *old = *trees;
+    *trees = old->next;
+    free(old);
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int inAPSTree (TNode *x) {
+  return (x->tree != NULL && x->tree->status == APSTREE);
+}
+
+//------------------------------------------------------------------- 
+
+static void processPath(TTree *tree, TNode *end) {
+
+  TNode *u, *v;
+  TEdge *uv, *vu;
+    
+  u = end;
+       
+  while (u != tree->root) {
+   
+    vu = u->entry;
+    uv = vu->reversed;
+    v  = uv->node;
+      
+    changeM(uv);
+      
+    u = v;
+  }
+    
+  tree->status = FREE;
+}
+
+//------------------------------------------------------------------- APPLY APS
+
+static int _applyAPS(TTree *tree, TQueue *Q, const TLimits *limits) {
+
+  DEBUG("Apply APS.")
+  
+  int error = EOK;  
+  int yM = 0, foundPath = 0;
+  int cuts = 0, late = 0;
+
+  // paths longer than the limit are not searched
+  const struct timespec *deadline = (limits != NULL && limits->cancel) ? limits->deadline : NULL;
+  int length = (limits != NULL && limits->length > 0) ? limits->length : INT_MAX;
+  
+  TNode *x, *y, *z, *pathEnd = NULL;
+  TEdge *xy, *yz;
+
+  // insert root into Q
+  tree->root->depth = 0;
+  error = pushQueue(Q, (void*) tree->root);
+  if (error != EOK) return error;
+  
+  // while Q is not empty and no path found
+  while(!isEmptyQueue(Q) && !foundPath) {
+
+    // get x
+    x = popQueue(Q);    
+    xy = x->edges;
+
+    // give the tree up after the deadline
+    if (isLate(deadline)) {
+      late = 1;
+      break;
+    }
+
+    // paths through x would be too long
+    if (x->depth + 1 > length) {
+      cuts++;
+      continue;
+    }
+
+    while(xy != NULL && !foundPath) {
+
+      // get y
+      y = xy->node;
+      if (y->tree == tree || inAPSTree(y)) {
+        xy = xy->next;
+        continue;
+      }
+
+      y->tree = tree;
+      y->entry = xy;
+      y->depth = x->depth + 1;
+      yM = 0;
+      
+      yz = y->edges;
+      while(yz != NULL) {
+            
+        // get z
+        z = yz->node;
+        if (!(yz->M) || (z->tree == tree) || inAPSTree(z)) {
+          yz = yz->next;
+          continue;
+        }
+
+        z->tree = tree;
+        z->entry = yz;
+        z->depth = y->depth + 1;
+        yM = 1;
+        
+        // add z to Q
+        error = pushQueue(Q, (void*) z);
+        if (error != EOK) return error;
+        
+        // get next edge
+        yz = yz->next;
+      }    
+      
+      // y is not in M, we found a path
+      if (!yM) {  
+        foundPath = 1;
+        pathEnd = y;
+      }
+      
+      // get next edge
+      xy = xy->next;      
+    }
+  }
+  
+  // we found M-path, change M
+  if(foundPath) {
+    processPath(tree, pathEnd);
+  }
+
+  // longer paths may exist, the nodes stay free for other trees
+  else if (cuts > 0 || late) {
+    tree->status = FREE;
+  }
+  
+  // we found APS-tree
+  else {
+    tree->status = APSTREE;
+  }
+
+  DEBUG("Finished apply APS.")
+  return EOK;
+}
+
+static int applyAPS(TTree *tree, const TLimits *limits) {
+
+  TQueue Q;
+  initQueue(&Q);
+  
+  int error = _applyAPS(tree, &Q, limits);
+
+  freeQueue(&Q);
+  return error;
+}
+
+//------------------------------------------------------------------- FIND MATCHING
+
+static int _findMatchingSequence(TGraph *graph, TTree **trees, const TLimits *limits, int *complete) {
+
+  int error = EOK;
+  const struct timespec *deadline = (limits != NULL) ? limits->deadline : NULL;
+
+  *complete = 0;
+  
+  for (TIndex i = 0; i < graph->n; i++) {
+    
+    // get node
+    TNode *node = &(graph->nodes[i]);
+
+    // does it belongs to M? yes, then skip this node.
+    if (inM(node) || inAPSTree(node)) continue;
+
+    // the rest of roots waits after the deadline
+    if (isLate(deadline)) return EOK;
+    
+    // create tree
+    TTree *tree = createTree(trees);
+    if (tree == NULL) return EALLOC;
+    graph->ntree++;
+      
+    tree->root = node; 
+    node->tree = tree;
+      
+    // find augmenting path
+    error = applyAPS(tree, limits);
+    if (error != EOK) return error;
+  }
+
+  *complete = !isLate(deadline);
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+static void _countMatching(TGraph *graph, TIndex *M, TIndex *free) {
+
+  *M = 0;
+  *free = 0;
+
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    TNode *node = &(graph->nodes[i]);
+
+    if (inM(node)) {
+      (*M)++;
+    }
+    else if (!inAPSTree(node)) {
+      (*free)++;
+    }
+  }
+
+  *M /= 2;
+}
+
+//-------------------------------------------------------------------
+
+int findMatchingSequenceBounded(TGraph *graph, const TLimits *limits) {
+
+  TTree *trees = NULL;
+  TIndex M = -1, size = 0, free = 0;
+  int proven = 0;
+  int complete = 0;
+  int error = EOK;
+
+  resetSearch(graph);
+
+  // cut trees may get short paths from later augmentations,
+  // sweep the roots again until a sweep changes nothing
+  while (error == EOK) {
+
+    error = _findMatchingSequence(graph, &trees, limits, &complete);
+    _countMatching(graph, &size, &free);
+
+    if (!complete || free == 0) break;
+    if (size == M) {
+      proven = 1;
+      break;
+    }
+
+    M = size;
+  }
+
+  if (limits != NULL) {
+    graph->bound = qualityBound(size, free, proven ? limits->length : 0);
+  }
+
+  // nodes must not point to the freed trees
+  for (TIndex i = 0; i < graph->n; i++) {
+    graph->nodes[i].tree = NULL;
+    graph->nodes[i].entry = NULL;
+  }
+
+  freeTrees(&trees);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+int findMatchingSequence(TGraph *graph) {
+  return findMatchingSequenceBounded(graph, NULL);
+}
+
+/* end of file */
@@ -0,0 +1,107 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Statistics of the parallel search. Every worker counts into its own
+ * TStats without locks, the counters are merged when the workers are
+ * done and written as a JSON report.
+ */
+
+#include <string.h>
+
+#include "internal.h"
+
+//------------------------------------------------------------------- MERGE
+
+static void _addStats(TStats *total, const TStats *stats) {
+
+  total->trees += stats->trees;
+  total->augmentations += stats->augmentations;
+  total->apsTrees += stats->apsTrees;
+  total->aborts += stats->aborts;
+  total->edges += stats->edges;
+
+  for (int i = 0; i <= PATH; i++) {
+    total->outcomes[i] += stats->outcomes[i];
+  }
+
+  for (int i = 0; i < STATS_BUCKETS; i++) {
+    total->paths[i] += stats->paths[i];
+    total->sizes[i] += stats->sizes[i];
+  }
+}
+
+//-------------------------------------------------------------------
+
+void mergeStats(TPool *pool, TStats *total) {
+
+  memset(total, 0, sizeof(TStats));
+
+  for (int i = 0; i < pool->n; i++) {
+    _addStats(total, &(pool->workers[i].stats));
+  }
+}
+
+//------------------------------------------------------------------- PRINT
+
+static void _printHistogram(const uint64_t *buckets, FILE *f) {
+
+  // up to the last used bucket
+  int last = STATS_BUCKETS - 1;
+  while (last > 0 && buckets[last] == 0) {
+    last--;
+  }
+
+  fprintf(f, "[");
+
+  for (int i = 0; i <= last; i++) {
+    fprintf(f, "%s%" PRIu64, (i > 0) ? ", " : "", buckets[i]);
+  }
+
+  fprintf(f, "]");
+}
+
+//-------------------------------------------------------------------
+
+static void _printStats(const TStats *stats, const char *indent, FILE *f) {
+
+  fprintf(f, "{\n");
+  fprintf(f, "%s  \"trees\": %" PRIu64 ",\n", indent, stats->trees);
+  fprintf(f, "%s  \"augmentations\": %" PRIu64 ",\n", indent, stats->augmentations);
+  fprintf(f, "%s  \"aps_trees\": %" PRIu64 ",\n", indent, stats->apsTrees);
+  fprintf(f, "%s  \"aborts\": %" PRIu64 ",\n", indent, stats->aborts);
+  fprintf(f, "%s  \"edges\": %" PRIu64 ",\n", indent, stats->edges);
+  fprintf(f, "%s  \"outcomes\": {\"ok\": %" PRIu64 ", \"ignore\": %" PRIu64
+             ", \"conflict\": %" PRIu64 ", \"path\": %" PRIu64 "},\n", indent,
+          stats->outcomes[OK], stats->outcomes[IGNORE], stats->outcomes[CONFLICT], stats->outcomes[PATH]);
+
+  fprintf(f, "%s  \"path_lengths\": ", indent);
+  _printHistogram(stats->paths, f);
+  fprintf(f, ",\n%s  \"tree_sizes\": ", indent);
+  _printHistogram(stats->sizes, f);
+  fprintf(f, "\n%s}", indent);
+}
+
+//-------------------------------------------------------------------
+
+void printStats(TPool *pool, FILE *f) {
+
+  TStats total;
+  mergeStats(pool, &total);
+
+  // histogram bucket i counts values in [2^i, 2^(i + 1))
+  fprintf(f, "{\n  \"threads\": %d,\n  \"buckets\": \"log2\",\n  \"total\": ", pool->n);
+  _printStats(&total, "  ", f);
+  fprintf(f, ",\n  \"workers\": [");
+
+  for (int i = 0; i < pool->n; i++) {
+    fprintf(f, "%s\n    ", (i > 0) ? "," : "");
+    _printStats(&(pool->workers[i].stats), "    ", f);
+  }
+
+  fprintf(f, "\n  ]\n}\n");
+}
+
+/* end of file */
@@ -0,0 +1,317 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Semi-streaming matching. The first pass over the edges builds a
+ * maximal matching greedily. The next passes grow alternating trees from
+ * all free nodes at once, by one BFS layer per pass, and augment along
+ * an edge between two trees. Paths are at most 2k - 1 edges long with
+ * k = ceil(1 / eps). A node joins a tree by its shortest alternating
+ * path, so a phase without augmentations proves that no augmenting path
+ * of 2k - 1 edges is left and the matching has k / (k + 1) of the
+ * maximum. No graph is built, the state is a few arrays over nodes.
+ */
+
+#include <limits.h>
+
+#include "internal.h"
+
+#define UNSEEN -1
+
+//------------------------------------------------------------------- INIT
+
+static int _openPass(FILE *f, TReader *reader, TStream *stream) {
+
+  // the first pass can read a pipe, the next ones rewind the file
+  if (stream->passes > 0 && fseek(f, 0, SEEK_SET) != 0) {
+    return EFILE;
+  }
+
+  int error = openReader(reader, f);
+  if (error == EOK && stream->passes > 0 && reader->n != stream->n) {
+    error = EINPUT;
+  }
+
+  stream->passes++;
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+static int _initStream(TStream *stream, TIndex n) {
+
+  stream->n = n;
+  stream->mates = malloc((size_t) n * sizeof(TIndex) + 1);
+  stream->roots = malloc((size_t) n * sizeof(TIndex) + 1);
+  stream->parents = malloc((size_t) n * sizeof(TIndex) + 1);
+  stream->layers = malloc((size_t) n * sizeof(int) + 1);
+  stream->dead = malloc((size_t) n * sizeof(uint8_t) + 1);
+
+  if (stream->mates == NULL || stream->roots == NULL || stream->parents == NULL
+     || stream->layers == NULL || stream->dead == NULL) {
+    return EALLOC;
+  }
+
+  for (TIndex i = 0; i < n; i++) {
+    stream->mates[i] = -1;
+  }
+
+  return EOK;
+}
+
+//------------------------------------------------------------------- GREEDY
+
+static int _greedyPass(FILE *f, TStream *stream) {
+
+  TReader *reader = malloc(sizeof(TReader));
+  if (reader == NULL) {
+    return EALLOC;
+  }
+
+  int error = _openPass(f, reader, stream);
+
+  if (error == EOK) {
+    error = _initStream(stream, reader->n);
+  }
+
+  // match an edge when both nodes are free
+  TIndex x, y;
+
+  while (error == EOK && nextEdge(reader, &x, &y)) {
+
+    if (x == y || x < 0 || y < 0 || x >= stream->n || y >= stream->n) {
+      continue;
+    }
+
+    stream->m++;
+
+    if (stream->mates[x] < 0 && stream->mates[y] < 0) {
+      stream->mates[x] = y;
+      stream->mates[y] = x;
+      stream->M++;
+    }
+  }
+
+  if (error == EOK) {
+    error = reader->error;
+  }
+
+  stream->greedy = stream->M;
+
+  free(reader);
+  return error;
+}
+
+//------------------------------------------------------------------- AUGMENT
+
+static void _initForest(TStream *stream) {
+
+  // every free node is a root of its own tree
+  for (TIndex i = 0; i < stream->n; i++) {
+
+    int free = (stream->mates[i] < 0);
+
+    stream->roots[i] = free ? i : UNSEEN;
+    stream->parents[i] = -1;
+    stream->layers[i] = free ? 0 : UNSEEN;
+    stream->dead[i] = 0;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static void _flipPath(TStream *stream, TIndex x) {
+
+  // x is an outer node, flip the matched and unmatched edges up to the root
+  while (stream->parents[x] >= 0) {
+
+    TIndex y = stream->parents[x];
+    TIndex w = stream->parents[y];
+
+    stream->mates[y] = w;
+    stream->mates[w] = y;
+    x = w;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int _visitEdge(TStream *stream, TIndex x, TIndex y, int frontier, int length) {
+
+  TIndex rx = stream->roots[x];
+  TIndex ry = stream->roots[y];
+
+  // x must be an outer node of a living tree
+  if (rx == UNSEEN || stream->dead[rx] || stream->layers[x] % 2 != 0) {
+    return 0;
+  }
+
+  // an edge between outer nodes of two trees closes an augmenting path
+  if (ry != UNSEEN && ry != rx && !stream->dead[ry] && stream->layers[y] % 2 == 0) {
+
+    if (stream->layers[x] + stream->layers[y] + 1 > length) {
+      return 0;
+    }
+
+    _flipPath(stream, x);
+    _flipPath(stream, y);
+    stream->mates[x] = y;
+    stream->mates[y] = x;
+
+    stream->dead[rx] = 1;
+    stream->dead[ry] = 1;
+    stream->M++;
+    return 1;
+  }
+
+  // grow the tree from the last layer by an unseen matched node and its mate
+  if (ry == UNSEEN && stream->layers[x] == frontier && stream->layers[x] + 3 <= length) {
+
+    TIndex z = stream->mates[y];
+
+    stream->roots[y] = rx;
+    stream->parents[y] = x;
+    stream->layers[y] = stream->layers[x] + 1;
+
+    stream->roots[z] = rx;
+    stream->parents[z] = y;
+    stream->layers[z] = stream->layers[x] + 2;
+    return 1;
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int _augmentPass(FILE *f, TStream *stream, int frontier, int length, int *changed) {
+
+  TReader *reader = malloc(sizeof(TReader));
+  if (reader == NULL) {
+    return EALLOC;
+  }
+
+  int error = _openPass(f, reader, stream);
+  TIndex x, y;
+
+  *changed = 0;
+
+  while (error == EOK && nextEdge(reader, &x, &y)) {
+
+    if (x == y || x < 0 || y < 0 || x >= stream->n || y >= stream->n) {
+      continue;
+    }
+
+    *changed |= _visitEdge(stream, x, y, frontier, length);
+    *changed |= _visitEdge(stream, y, x, frontier, length);
+  }
+
+  if (error == EOK) {
+    error = reader->error;
+  }
+
+  free(reader);
+  return error;
+}
+
+//------------------------------------------------------------------- FIND MATCHING
+
+int matchStream(TStream *stream, FILE *f, int passes, double eps) {
+
+  stream->n = 0;
+  stream->m = 0;
+  stream->M = 0;
+  stream->greedy = 0;
+  stream->passes = 0;
+  stream->bound = -1;
+  stream->mates = NULL;
+  stream->roots = NULL;
+  stream->parents = NULL;
+  stream->layers = NULL;
+  stream->dead = NULL;
+
+  int error = _greedyPass(f, stream);
+
+  // augmenting paths of at most 2k - 1 edges, any length without eps
+  int length = INT_MAX / 2;
+
+  if (eps > 0) {
+    int k = (eps < 1) ? (int) (1 / eps) : 1;
+    if (k < 1 / eps) k++;
+    length = 2 * k - 1;
+  }
+
+  // the greedy matching is maximal, no path of one edge is left
+  int proven = 1;
+
+  // each phase grows a forest until it stops changing
+  while (error == EOK && passes > 0) {
+
+    TIndex M = stream->M;
+    int changed = 1;
+    int frontier = 0;
+
+    _initForest(stream);
+
+    while (error == EOK && changed && passes > 0) {
+      error = _augmentPass(f, stream, frontier, length, &changed);
+      frontier += 2;
+      passes--;
+    }
+
+    // a complete phase without augmentations left no path within the length
+    if (!changed && stream->M == M) {
+      proven = length;
+      break;
+    }
+  }
+
+  if (error == EOK) {
+    stream->bound = qualityBound(stream->M, stream->n - 2 * stream->M, proven);
+  }
+
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void freeStream(TStream *stream) {
+
+  free(stream->mates);
+  free(stream->roots);
+  free(stream->parents);
+  free(stream->layers);
+  free(stream->dead);
+}
+
+//------------------------------------------------------------------- PRINT
+
+void printStream(TStream *stream, FILE *f) {
+
+  TIndex M = 0;
+  fprintf(f, "<Matching>\n");
+
+  // print edges in matching
+  for (TIndex i = 0; i < stream->n; i++) {
+
+    if (i < stream->mates[i]) {
+      fprintf(f, "(%" PRIINDEX ",%" PRIINDEX ") ", i, stream->mates[i]);
+      M++;
+    }
+  }
+
+  if (M != 0) {
+    fprintf(f, "\n\n");
+  }
+
+  fprintf(f, "<Nodes>\n%" PRIINDEX "\n\n", stream->n);
+  fprintf(f, "<Edges>\n%" PRIINDEX "\n\n", stream->m);
+  fprintf(f, "<Passes>\n%d\n\n", stream->passes);
+  fprintf(f, "<Greedy>\n%" PRIINDEX "\n\n", stream->greedy);
+  fprintf(f, "<Bound>\n%.4f\n\n", stream->bound);
+  fprintf(f, "<M>\n%" PRIINDEX "\n", M);
+}
+
+/* end of file */
@@ -0,0 +1,140 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Timeline of the parallel search. Every worker writes spans of its
+ * trees and of waits for locks (see lock.c) into its own ring buffer, the oldest
+ * events are overwritten. The buffers are written in the trace event
+ * format of Chrome and Perfetto. Without a trace the workers only test
+ * a pointer.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+
+#include "internal.h"
+
+static const char *_eventNames[] = {"tree", "wait node", "wait tree", "wait graph", "wait queue", "requeue"};
+static const char *_endNames[] = {"path", "aps", "abort", "cut"};
+
+//------------------------------------------------------------------- RECORD
+
+uint64_t traceClock(void) {
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+//-------------------------------------------------------------------
+
+void traceEvent(TTrace *trace, int type, uint64_t start, TIndex root, int end, TIndex nodes) {
+
+  TEvent *event = &(trace->events[trace->count % trace->size]);
+
+  event->start = start;
+  event->duration = traceClock() - start;
+  event->root = root;
+  event->nodes = nodes;
+  event->type = type;
+  event->end = end;
+
+  trace->count++;
+}
+
+//------------------------------------------------------------------- INIT
+
+int initTrace(TPool *pool, size_t size) {
+
+  pool->start = traceClock();
+
+  for (int i = 0; i < pool->n; i++) {
+
+    TTrace *trace = malloc(sizeof(TTrace) + size * sizeof(TEvent));
+    if (trace == NULL) {
+      return EALLOC;
+    }
+
+    trace->size = size;
+    trace->count = 0;
+    pool->workers[i].trace = trace;
+  }
+
+  return EOK;
+}
+
+//-------------------------------------------------------------------
+
+void freeTrace(TPool *pool) {
+
+  for (int i = 0; i < pool->n; i++) {
+    free(pool->workers[i].trace);
+    pool->workers[i].trace = NULL;
+  }
+}
+
+//------------------------------------------------------------------- WRITE
+
+static void _writeEvent(TEvent *event, int tid, uint64_t base, int *first, FILE *f) {
+
+  // times in microseconds from the start of the pool
+  double ts = (event->start - base) / 1000.0;
+  double dur = event->duration / 1000.0;
+
+  fprintf(f, "%s\n    {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%s\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f",
+          *first ? "" : ",", _eventNames[event->type],
+          (event->type == TREE_SPAN) ? "search" : "sync",
+          (event->type == REQUEUE) ? "i" : "X", tid, ts);
+
+  if (event->type == REQUEUE) {
+    fprintf(f, ", \"s\": \"t\", \"args\": {\"root\": %" PRIINDEX "}}", event->root);
+  }
+  else if (event->type == TREE_SPAN) {
+    fprintf(f, ", \"dur\": %.3f, \"args\": {\"root\": %" PRIINDEX ", \"outcome\": \"%s\", \"nodes\": %" PRIINDEX "}}",
+            dur, event->root, _endNames[event->end], event->nodes);
+  }
+  else {
+    fprintf(f, ", \"dur\": %.3f}", dur);
+  }
+
+  *first = 0;
+}
+
+//-------------------------------------------------------------------
+
+int writeTrace(TPool *pool, FILE *f) {
+
+  int first = 1;
+  fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+  for (int i = 0; i < pool->n; i++) {
+
+    TWorker *worker = &(pool->workers[i]);
+    TTrace *trace = worker->trace;
+
+    if (trace == NULL) continue;
+
+    fprintf(f, "%s\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+               "\"args\": {\"name\": \"worker %d\"}}", first ? "" : ",", worker->id, worker->id);
+    first = 0;
+
+    // the ring keeps the last events
+    uint64_t from = (trace->count > trace->size) ? trace->count - trace->size : 0;
+
+    for (uint64_t k = from; k < trace->count; k++) {
+      _writeEvent(&(trace->events[k % trace->size]), worker->id, pool->start, &first, f);
+    }
+
+    if (from > 0) {
+      fprintf(stderr, "WARNING worker %d lost %" PRIu64 " trace events\n", worker->id, from);
+    }
+  }
+
+  fprintf(f, "\n]}\n");
+  return ferror(f) ? EFILE : EOK;
+}
+
+/* end of file */
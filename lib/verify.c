@@ -0,0 +1,311 @@
+/*
+ * Project: GAL 2014 - library of matching in bipartite graphs
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Certificate of a maximum matching. Workers check that the edges in M
+ * form a matching, the nodes are split into the sides of the graph and
+ * the nodes reachable from free nodes of the first side by alternating
+ * paths give the Konig cover: the unreached nodes of the first side and
+ * the reached nodes of the second one. A cover of |M| nodes proves that
+ * no matching is larger. All steps are O(n + m).
+ */
+
+#include <string.h>
+
+#include "internal.h"
+
+#define UNSEEN 2
+
+typedef struct tRange TRange;
+
+struct tRange {
+  TIndex lo;
+  TIndex hi;
+  TIndex count;
+  TIndex other;
+  int valid;
+  TCertificate *cert;
+};
+
+//------------------------------------------------------------------- RANGES
+
+static int _runRanges(TPool *pool, TGraph *graph, TCertificate *cert,
+                      int (*task)(TJob *job, TWorker *worker), TIndex *count, TIndex *other) {
+
+  int n = (pool != NULL) ? pool->n : 1;
+  int error = EOK;
+
+  TJob *jobs = malloc(n * sizeof(TJob));
+  TRange *ranges = malloc(n * sizeof(TRange));
+
+  if (jobs == NULL || ranges == NULL) {
+    free(jobs);
+    free(ranges);
+    return EALLOC;
+  }
+
+  // every worker gets a range of nodes
+  for (int i = 0; i < n; i++) {
+
+    ranges[i].lo = (TIndex) ((int64_t) graph->n * i / n);
+    ranges[i].hi = (TIndex) ((int64_t) graph->n * (i + 1) / n);
+    ranges[i].count = 0;
+    ranges[i].other = 0;
+    ranges[i].valid = 1;
+    ranges[i].cert = cert;
+
+    jobs[i].task = task;
+    jobs[i].graph = graph;
+    jobs[i].data = &ranges[i];
+    jobs[i].error = EOK;
+    jobs[i].done = 1;
+
+    if (pool == NULL) {
+      jobs[i].error = task(&jobs[i], NULL);
+    }
+    else if (error == EOK) {
+      error = submitJob(pool, &jobs[i]);
+    }
+  }
+
+  if (pool != NULL) {
+    waitJobs(pool, jobs, n);
+  }
+
+  *count = 0;
+  *other = 0;
+
+  for (int i = 0; i < n; i++) {
+
+    if (error == EOK) error = jobs[i].error;
+
+    *count += ranges[i].count;
+    *other += ranges[i].other;
+    cert->valid &= ranges[i].valid;
+  }
+
+  free(jobs);
+  free(ranges);
+  return error;
+}
+
+//------------------------------------------------------------------- MATCHING
+
+static int _checkMatching(TJob *job, TWorker *worker) {
+
+  (void) worker;
+
+  TRange *range = job->data;
+  TNode *nodes = job->graph->nodes;
+
+  // each node has at most one edge in M, the same as its reversed edge
+  for (TIndex i = range->lo; i < range->hi; i++) {
+
+    TIndex mate = -1, matched = 0;
+
+    for (TEdge *edge = nodes[i].edges; edge != NULL; edge = edge->next) {
+
+      if (edge->M != edge->reversed->M || (edge->M && edge->node == &nodes[i])) {
+        range->valid = 0;
+      }
+
+      if (edge->M) {
+        mate = edge->node->id;
+        matched++;
+      }
+    }
+
+    if (matched > 1) {
+      range->valid = 0;
+    }
+
+    range->cert->mates[i] = mate;
+    range->count += (mate >= 0);
+  }
+
+  return EOK;
+}
+
+//------------------------------------------------------------------- SIDES
+
+static int _splitSides(TGraph *graph, TCertificate *cert, TIndex *queue) {
+
+  uint8_t *side = cert->side;
+  memset(side, UNSEEN, (size_t) graph->n);
+
+  // two colours by breadth first search from every unseen node
+  for (TIndex s = 0; s < graph->n; s++) {
+
+    if (side[s] != UNSEEN) continue;
+
+    TIndex first = 0, last = 0;
+    queue[last++] = s;
+    side[s] = 0;
+
+    while (first < last) {
+
+      TIndex x = queue[first++];
+
+      for (TEdge *edge = graph->nodes[x].edges; edge != NULL; edge = edge->next) {
+
+        TIndex y = edge->node->id;
+
+        if (side[y] == UNSEEN) {
+          side[y] = !side[x];
+          queue[last++] = y;
+        }
+        else if (side[y] == side[x]) {
+          return EINPUT;
+        }
+      }
+    }
+  }
+
+  return EOK;
+}
+
+//------------------------------------------------------------------- COVER
+
+void reachFree(TGraph *graph, TCertificate *cert, int side, uint8_t *reached, TIndex *queue) {
+
+  TIndex first = 0, last = 0;
+
+  memset(reached, 0, (size_t) graph->n);
+
+  // free nodes of the side start the alternating paths
+  for (TIndex i = 0; i < graph->n; i++) {
+
+    if (cert->side[i] == side && cert->mates[i] < 0) {
+      reached[i] = 1;
+      queue[last++] = i;
+    }
+  }
+
+  // leave the side by a free edge, come back by the matched one
+  while (first < last) {
+
+    TIndex x = queue[first++];
+
+    for (TEdge *edge = graph->nodes[x].edges; edge != NULL; edge = edge->next) {
+
+      TIndex y = edge->node->id;
+      if (edge->M || reached[y]) continue;
+
+      reached[y] = 1;
+      TIndex z = cert->mates[y];
+
+      if (z >= 0 && !reached[z]) {
+        reached[z] = 1;
+        queue[last++] = z;
+      }
+    }
+  }
+}
+
+//-------------------------------------------------------------------
+
+static void _findCover(TGraph *graph, TCertificate *cert, TIndex *queue) {
+
+  uint8_t *reached = cert->cover;
+  reachFree(graph, cert, 0, reached, queue);
+
+  // the cover is the unreached first side and the reached second side
+  for (TIndex i = 0; i < graph->n; i++) {
+    cert->cover[i] = (cert->side[i] == 0) ? !reached[i] : reached[i];
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int _checkCover(TJob *job, TWorker *worker) {
+
+  (void) worker;
+
+  TRange *range = job->data;
+  TNode *nodes = job->graph->nodes;
+  uint8_t *cover = range->cert->cover;
+
+  // count the cover and the edges it misses
+  for (TIndex i = range->lo; i < range->hi; i++) {
+
+    range->count += cover[i];
+
+    for (TEdge *edge = nodes[i].edges; edge != NULL; edge = edge->next) {
+      if (!cover[i] && !cover[edge->node->id]) {
+        range->other++;
+      }
+    }
+  }
+
+  return EOK;
+}
+
+//------------------------------------------------------------------- VERIFY
+
+int verifyMatching(TPool *pool, TGraph *graph, TCertificate *cert) {
+
+  TIndex n = graph->n, other;
+
+  cert->M = 0;
+  cert->size = 0;
+  cert->uncovered = 0;
+  cert->valid = 1;
+  cert->verified = 0;
+  cert->mates = malloc((size_t) n * sizeof(TIndex) + 1);
+  cert->side = malloc((size_t) n + 1);
+  cert->cover = malloc((size_t) n + 1);
+
+  TIndex *queue = malloc((size_t) n * sizeof(TIndex) + 1);
+  int error = EOK;
+
+  if (cert->mates == NULL || cert->side == NULL || cert->cover == NULL || queue == NULL) {
+    error = EALLOC;
+  }
+
+  // is M a matching
+  if (error == EOK) {
+    error = _runRanges(pool, graph, cert, &_checkMatching, &(cert->M), &other);
+    cert->M /= 2;
+  }
+
+  if (error == EOK && cert->valid) {
+    error = _splitSides(graph, cert, queue);
+  }
+
+  // is the Konig cover as large as M
+  if (error == EOK && cert->valid) {
+
+    _findCover(graph, cert, queue);
+    error = _runRanges(pool, graph, cert, &_checkCover, &(cert->size), &(cert->uncovered));
+
+    // edges are in the lists of both nodes
+    cert->uncovered /= 2;
+    cert->verified = (cert->uncovered == 0 && cert->size == cert->M);
+  }
+
+  free(queue);
+  return error;
+}
+
+//-------------------------------------------------------------------
+
+void freeCertificate(TCertificate *cert) {
+
+  free(cert->mates);
+  free(cert->side);
+  free(cert->cover);
+}
+
+//------------------------------------------------------------------- PRINT
+
+void printCertificate(TCertificate *cert, FILE *f) {
+
+  fprintf(f, "<Valid>\n%d\n\n", cert->valid);
+  fprintf(f, "<Cover>\n%" PRIINDEX "\n\n", cert->size);
+  fprintf(f, "<Uncovered>\n%" PRIINDEX "\n\n", cert->uncovered);
+  fprintf(f, "<Verified>\n%d\n", cert->verified);
+}
+
+/* end of file */
@@ -5,985 +5,1387 @@
  * Date:    4.12.2014
  */
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <pthread.h>
-#include <stdarg.h>
-
-#define DEBUG(y) //y;
-
-//------------------------------------------------------------------- ENUMS
-
-enum errors {
-  EOK = 0,
-  EPARAM,
-  EFILE,
-  EINPUT,
-  EALLOC,
-  EQUEUE,
-  EINTERN,
-  EUNKNOWN
-};
+#define _GNU_SOURCE
 
-enum colours {
-  RED = 0,
-  BLUE,
-  GREEN,
-  WHITE
-};
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
-enum treestat {
-  FREE = 0,
-  INPROCESS,
-  HASPATH,
-  APSTREE
-};
+#include "../lib/internal.h"
+
+//------------------------------------------------------------------- BATCH
 
-enum retstat {
-  OK = 0,
-  ABORT,
-  IGNORE,
-  CONFLICT,
-  PATH
+#define BATCHSIZE  64
+#define MAXPATH    4096
+
+typedef struct tBatch TBatch;
+
+struct tBatch {
+  int n;
+  int count;
+  int errors;
+  int manifest;
+  FILE *input;
+
+  TGraph graphs[BATCHSIZE];
+  TJob jobs[BATCHSIZE];
+  char names[BATCHSIZE][MAXPATH];
 };
 
-//------------------------------------------------------------------- TYPES
+//-------------------------------------------------------------------
 
-typedef struct tGraph TGraph;
-typedef struct tTree TTree;
-typedef struct tNode TNode;
-typedef struct tEdge TEdge;
+int nextGraph(TBatch *batch, TGraph *graph, char *name) {
 
-typedef struct tList TList;
-typedef struct tQueue TQueue;
-typedef struct tItem TItem;
+  FILE *f = batch->input;
+  char path[MAXPATH];
+  int error = EOK;
 
-typedef pthread_t TThread;
-typedef pthread_mutex_t TMutex;
-typedef struct tThreadData TThreadData;
+  // read the next path from the manifest
+  if (batch->manifest) {
 
-struct tList {
-  TItem *last;
-};
+    do {
+      if (fgets(path, MAXPATH, batch->input) == NULL) {
+        return EOF;
+      }
+      path[strcspn(path, "\r\n")] = '\0';
+    }
+    while(path[0] == '\0');
 
-struct tQueue {
-  TItem *first;
-  TItem *last;
-};
+    strcpy(name, path);
+    f = fopen(path, "r");
 
-struct tItem {
-  void *item;
-  TItem *next;
-};
+    if (f == NULL) {
+      reuseGraph(graph, 0, 0);
+      return EFILE;
+    }
+  }
+  // or check the end of the stream
+  else {
+    if (fscanf(f, " ") == EOF || feof(f)) {
+      return EOF;
+    }
 
-struct tGraph {
-  int n;
-  int m;
-  TNode *nodes;
+    sprintf(name, "%d", batch->count + 1);
+  }
   
-  int ntree;
-  TMutex mutex;
-};
+  // load the graph into the reused buffers
+  error = reloadGraph(graph, f);
 
-struct tTree {
-  int id;
-  int status;
-  int owner; 
+  if (batch->manifest) {
+    fclose(f);
+  }
 
-  TNode *root;
-  TNode *pathEnd;
-  
-  TList nodes;
-  TMutex mutex;
-};
+  return error;
+}
 
-struct tNode {
-  int id;
-  int colour;
+//-------------------------------------------------------------------
 
-  TEdge *edges;
-  TEdge *entry;
-  TTree *tree;
-  TMutex mutex;
-};
+int findMatchingBatch(TBatch *batch, TPool *pool, FILE *out) {
 
-struct tEdge {
-  int M;
-  TNode *node;
-  TEdge *reversed;
-  TEdge *next;
-};
+  int error = EOK, k = 0, end = 0;
 
-struct tThreadData {
-  int id;
-  int error;
-  TGraph *graph;
-  TQueue *queue;
-  TMutex *mutex;
-};
+  while(!end) {
 
-//------------------------------------------------------------------- PRINT
+    // load the window of graphs until a large one
+    for (k = 0; k < BATCHSIZE; k++) {
 
-void msg(char *format, int id, ...)
-{
-   va_list args;
-   va_start(args, id);
-   fprintf(stderr, "DEBUG[%d] ", id);
-   vfprintf(stderr, format, args);
-   fprintf(stderr, "\n");
-   va_end(args);
-}
+      TJob *job = &(batch->jobs[k]);
+      job->graph = &(batch->graphs[k]);
+      job->error = nextGraph(batch, job->graph, batch->names[k]);
 
-void msgt(char *format, TTree *t, ...)
-{
-   va_list args;
-   va_start(args, t);
-   fprintf(stderr, "DEBUG[%d:%d] ", t->owner, t->id);
-   vfprintf(stderr, format, args);
-   fprintf(stderr, "\n");
-   va_end(args);
-}
+      if (job->error == EOF) {
+        end = 1;
+        break;
+      }
 
-//------------------------------------------------------------------- LIST
+      batch->count++;
 
-void initList(TList *L) {
-  L->last = NULL;
-}
+      // the rest of a broken stream cannot be read
+      if (job->error != EOK && !batch->manifest) {
+        k++;
+        end = 1;
+        break;
+      }
+      
+      if (job->graph->m >= SMALLGRAPH) {
+        k++;
+        break;
+      }
+    }
 
-int isEmptyList(TList *L) {
-  return (L->last == NULL);
-}
+    // small graphs are matched by one worker each
+    for (int i = 0; i < k; i++) {
 
-int pushList(TList *L, void *item) {
+      TJob *job = &(batch->jobs[i]);
+      job->task = &_findMatchingAlone;
 
-  TItem *litem = malloc(sizeof(TItem));
-  
-  if (litem == NULL) {
-    return EALLOC;
-  }
+      if (job->error == EOK && job->graph->m < SMALLGRAPH) {
+        error = submitJob(pool, job);
+        if (error != EOK) return error;
+      }
+    }
 
-  litem->item = item;
-  litem->next = L->last;
-  L->last = litem;
-  
-  return EOK;
-}
+    waitPool(pool);
 
-void* popList(TList *L) {
+    // large graphs are shared by all workers
+    for (int i = 0; i < k; i++) {
 
-  void *item = L->last->item; 
-  
-  TItem *litem = L->last;
-  L->last = litem->next;
-  free(litem);
-  
-  return item;
-}
+      TJob *job = &(batch->jobs[i]);
 
-void freeList(TList *L) {
-  while(!isEmptyList(L)) popList(L);
-}
+      if (job->error == EOK && job->graph->m >= SMALLGRAPH) {
+        job->error = findMatchingInPool(pool, job->graph);
+      }
+    }
 
-//------------------------------------------------------------------- QUEUE
+    // print results in the order of input
+    for (int i = 0; i < k; i++) {
 
-void initQueue(TQueue *Q) {
-  Q->first = NULL;
-  Q->last = NULL;
-}
+      TJob *job = &(batch->jobs[i]);
+      fprintf(out, "<Instance>\n%s\n\n", batch->names[i]);
+      
+      if (job->error == EOK) {
+        printMatching(job->graph, out);
+      }
+      else {
+        fprintf(out, "<Error>\n%d\n", job->error);
+        batch->errors++;
+      }
+
+      fprintf(out, "\n");
+    }
+  }
 
-int isEmptyQueue(TQueue *Q) {
-  return (Q->first == NULL);
+  return EOK;
 }
 
-int pushQueue(TQueue *Q, void *item) {
+//-------------------------------------------------------------------
+
+int runBatch(char *fname, int manifest, int n) {
+
+  int error = EOK;
   
-  TItem *qitem = malloc(sizeof(TItem));
-  if (qitem == NULL) {
+  // allocate batch
+  TBatch *batch = malloc(sizeof(TBatch));
+  if (batch == NULL) {
     return EALLOC;
   }
-  
-  qitem->item = item;
-  qitem->next = NULL;
-  
-  if (Q->first == NULL) {
-    Q->first = qitem;
+
+  // open input
+  batch->input = (strcmp(fname, "-") == 0) ? stdin : fopen(fname, "r");
+  if (batch->input == NULL) {
+    free(batch);
+    return EFILE;
   }
 
-  if (Q->last != NULL) {
-    Q->last->next = qitem;
+  batch->n = n;
+  batch->count = 0;
+  batch->errors = 0;
+  batch->manifest = manifest;
+
+  // the buffers of graphs are allocated once and reused
+  for (int i = 0; i < BATCHSIZE; i++) {
+    initGraph(&(batch->graphs[i]), 0, 0);
   }
-  
-  Q->last = qitem;
-  
-  return EOK;
-}
 
-void* popQueue(TQueue *Q) {
-  
-  if (isEmptyQueue(Q)) {
-    return NULL;
+  // match all graphs with one pool
+  TPool pool;
+  error = initPool(&pool, n);
+  if (error == EOK) {
+    error = findMatchingBatch(batch, &pool, stdout);
   }
-  
-  void *item = Q->first->item;
-  
-  TItem *old = Q->first;
-  Q->first = Q->first->next;
-  
-  if (Q->first == NULL) {
-    Q->last = NULL;
+  freePool(&pool);
+
+  if (error == EOK && batch->errors > 0) {
+    error = EINPUT;
+  }
+
+  // free batch
+  for (int i = 0; i < BATCHSIZE; i++) {
+    freeGraph(&(batch->graphs[i]));
+  }
+
+  if (batch->input != stdin) {
+    fclose(batch->input);
   }
-  
-  free(old);
-  return item;
-}
 
-void freeQueue(TQueue *Q) {
-  while(!isEmptyQueue(Q)) popQueue(Q);
+  free(batch);
+  return error;
 }
 
-//------------------------------------------------------------------- GRAPH
+//------------------------------------------------------------------- SERVER
 
-int initGraph(TGraph *graph, int n) {
+#define LATENCIES   4096
+#define RECVTIMEOUT 30
+#define CHUNKSIZE   65536
 
-  // init graph
-  graph->n = n;
-  graph->m = 0;
-  graph->ntree = 0;
-  graph->nodes = malloc(n * sizeof(TNode));
+typedef struct tServer TServer;
+typedef struct tSlot TSlot;
+typedef struct tClient TClient;
 
-  if(graph->nodes == NULL) {
-    return EALLOC;
-  }
+struct tClient {
+  int fd;
+  struct timespec start;
+};
 
-  // init graph mutex
-  pthread_mutex_init(&(graph->mutex), NULL); 
-  
-  // init nodes
-  TNode *node = NULL;
-  for(int i = 0; i < n; i++) {
-  
-    node = &(graph->nodes[i]);
-    node->id = i;
-    node->colour = WHITE;
-    node->edges = NULL;
-    node->entry = NULL;
-    node->tree = NULL;   
-    
-    pthread_mutex_init(&(node->mutex), NULL); 
-  }
-  
-  return EOK;
-}
+struct tSlot {
+  int id;
+  TThread thread;
+  TServer *server;
 
-//-------------------------------------------------------------------
+  TGraph graph;
+  char *buffer;
+  size_t size;
+};
 
-void freeGraph(TGraph *graph) {
+struct tServer {
+  int fd;
+  int stop;
+  int limit;
+  int admitted;
+  int requests;
+  int rejected;
 
-  // free edges  
-  for(int i=0; i < graph->n; i++) {
-    TNode *node = &(graph->nodes[i]);
-    TEdge *edge = node->edges;
-    
-    while (edge != NULL) {
-      TEdge *old = edge;
-      edge = edge->next;
-      free(old);
-    }
-    
-    pthread_mutex_destroy(&(node->mutex));
-  }
-  
-  // free nodes
-  free(graph->nodes);
-  // free mutex
-  pthread_mutex_destroy(&(graph->mutex));  
-}
+  TPool *pool;
+  TSlot *slots;
+  int nslots;
 
-//-------------------------------------------------------------------
+  TQueue clients;
+  TMutex mutex;
+  TCond work;
 
-int addEdge(TGraph *graph, int idA, int idB) {
+  double latencies[LATENCIES];
+};
 
-  // check input
-  if (idA == idB || idA >= graph->n || idB >= graph->n) {
-    return EINPUT;
-  }
+volatile sig_atomic_t serverStop = 0;
 
-  // get nodes
-  TNode *A = &(graph->nodes[idA]);
-  TNode *B = &(graph->nodes[idB]);
-    
-  // allocate edges
-  TEdge *edgeAB = malloc(sizeof(TEdge));
-  TEdge *edgeBA = malloc(sizeof(TEdge));
-  
-  if (edgeAB == NULL || edgeBA == NULL) {
-    return EALLOC;  
-  }
-  
-  // init edge from A to B
-  edgeAB->M = 0;
-  edgeAB->node = B;
-  edgeAB->reversed = edgeBA;
-  edgeAB->next = A->edges;
-  A->edges = edgeAB;
-  
-  // init edge from B to A
-  edgeBA->M = 0;
-  edgeBA->node = A;
-  edgeBA->reversed = edgeAB;
-  edgeBA->next = B->edges;
-  B->edges = edgeBA;
-  
-  // increment number of edges
-  graph->m++;
-  
-  return EOK;
+//-------------------------------------------------------------------
+
+void _stopServer(int signal) {
+  (void) signal;
+  serverStop = 1;
 }
 
 //-------------------------------------------------------------------
 
-int loadGraph(TGraph *graph, FILE *f) {
+double elapsed(struct timespec *start) {
 
-  // init
-  int n = 0, m = 0, x = 0, y = 0;
-  
-  // read numbers of vertices and edges
-  if(fscanf(f, "%d %d", &n, &m) != 2) {
-    return EINPUT;
-  }
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
 
-  // init graph
-  initGraph(graph, n);
-  
-  // read edges
-  for (int i = 1; i <= m; i++) {
-  
-    if(fscanf(f, "%d %d", &x, &y) != 2) {
-      return EINPUT;
-    }
-    
-    addEdge(graph, x, y);
-  }
-    
-  return EOK;
+  return (end.tv_sec - start->tv_sec) * 1e6 + (end.tv_nsec - start->tv_nsec) / 1e3;
 }
 
 //-------------------------------------------------------------------
 
-void printGraph(TGraph *graph, FILE *f) {
-
-  fprintf(f, "<Graph>\n");
-  for(int i = 0; i < graph->n; i++) {
-  
-    TNode *node = &(graph->nodes[i]);
-    if (node != NULL) {
-    
-      fprintf(f, "Node %d: ", node->id);  
+int _compareDouble(const void *a, const void *b) {
 
-      TEdge *edge = node->edges;      
-      while(edge != NULL) {
-      
-        fprintf(f, "%d[%d] ", edge->node->id, edge->M);  
-        edge = edge->next;
-      }
-      
-      fprintf(f, "\n");  
-    }
-  }
+  double x = *(const double*) a;
+  double y = *(const double*) b;
+  return (x > y) - (x < y);
 }
 
 //-------------------------------------------------------------------
 
-void printMatching(TGraph *graph, FILE *f) {
+void printLatency(TServer *server, FILE *f) {
 
-  int M = 0;
-  fprintf(f, "<Matching>\n");
-  
-  // print edges in matching
-  for(int i = 0; i < graph->n; i++) {
-  
-    TNode *node = &(graph->nodes[i]);
-    if (node != NULL) {
-    
-      TEdge *edge = node->edges;      
-      while(edge != NULL) {
-        
-        if (node->id < edge->node->id && edge->M) {      
-          fprintf(f, "(%d,%d) ", node->id, edge->node->id); 
-          M++;
-        }
+  // sort a copy of the recent latencies
+  pthread_mutex_lock(&(server->mutex));
 
-        edge = edge->next;
-      }
-    }
-  }
-  
-  if (M != 0) {
-    fprintf(f, "\n\n");  
-  }
-  
-  fprintf(f, "<Nodes>\n%d\n\n", graph->n);
-  fprintf(f, "<Edges>\n%d\n\n", graph->m);
-  fprintf(f, "<Trees>\n%d\n\n", graph->ntree);
-  fprintf(f, "<M>\n%d\n", M);  
-}
+  int n = (server->requests < LATENCIES) ? server->requests : LATENCIES;
+  double sorted[LATENCIES];
+  memcpy(sorted, server->latencies, n * sizeof(double));
 
-//------------------------------------------------------------------- SYNC
+  int requests = server->requests;
+  int rejected = server->rejected;
+  pthread_mutex_unlock(&(server->mutex));
 
-void lockNode(TNode *node) {
-  pthread_mutex_lock(&(node->mutex));
-}
+  qsort(sorted, n, sizeof(double), &_compareDouble);
 
-void unlockNode(TNode *node) {
-  pthread_mutex_unlock(&(node->mutex));
-}
+  double p50 = (n > 0) ? sorted[(n - 1) / 2] : 0;
+  double p99 = (n > 0) ? sorted[(n - 1) * 99 / 100] : 0;
 
-void lockTree(TTree *tree) {
-  pthread_mutex_lock(&(tree->mutex));
+  fprintf(f, "LATENCY requests=%d rejected=%d window=%d p50=%.0fus p99=%.0fus\n",
+          requests, rejected, n, p50, p99);
 }
 
-void unlockTree(TTree *tree) {
-  pthread_mutex_unlock(&(tree->mutex));
-}
+//-------------------------------------------------------------------
 
-void lockNodes(TNode *nodeA, TNode *nodeB) {
+int receiveRequest(TSlot *slot, int fd, char **data, size_t *size, int *mapped) {
 
-  if (nodeA->id < nodeB->id) {
-    pthread_mutex_lock(&(nodeA->mutex));
-    pthread_mutex_lock(&(nodeB->mutex));
-  }
-  else {
-    pthread_mutex_lock(&(nodeB->mutex));
-    pthread_mutex_lock(&(nodeA->mutex));  
-  }
-}
+  char byte = 0;
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov;
+  struct msghdr msg;
 
-void lockTrees(TTree *treeA, TTree *treeB) {
+  *data = NULL;
+  *size = 0;
+  *mapped = 0;
 
-  if (treeA->id < treeB->id) {
-    pthread_mutex_lock(&(treeA->mutex));
-    pthread_mutex_lock(&(treeB->mutex));
-  }
-  else {
-    pthread_mutex_lock(&(treeB->mutex));
-    pthread_mutex_lock(&(treeA->mutex));  
+  // receive the first chunk with a possible descriptor
+  iov.iov_base = slot->buffer;
+  iov.iov_len = slot->size;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t count = recvmsg(fd, &msg, 0);
+  if (count < 0) {
+    return ESOCKET;
   }
-}
 
-//------------------------------------------------------------------- TREE
+  // the graph is in the passed memory file
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
 
-TTree *createTree(TGraph *graph) {
+    int memfd = -1;
+    struct stat st;
+    memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
 
-  // allocate tree
-  TTree *tree = malloc(sizeof(TTree));
-  if (tree == NULL) {
-    return NULL;
-  }
-  
-  // init tree
-  tree->status = INPROCESS;
-  tree->root = NULL;
-  tree->owner = 0;
-  tree->pathEnd = NULL;
-  
-  // init list of nodes
-  initList(&(tree->nodes));
-  
-  // init mutex
-  pthread_mutex_init(&(tree->mutex), NULL); 
+    if (fstat(memfd, &st) != 0 || st.st_size <= 0) {
+      close(memfd);
+      return EINPUT;
+    }
 
-  // critical section
-  pthread_mutex_lock(&(graph->mutex));  
-  tree->id = graph->ntree++;    
-  pthread_mutex_unlock(&(graph->mutex));  
-  
-  return tree;
-}
+    *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, memfd, 0);
+    close(memfd);
 
-//-------------------------------------------------------------------
+    if (*data == MAP_FAILED) {
+      *data = NULL;
+      return EALLOC;
+    }
 
-void freeTree(TTree *tree) {
+    *size = st.st_size;
+    *mapped = 1;
 
-  // free list of nodes
-  freeList(&(tree->nodes));
-  
-  // free tree
-  pthread_mutex_destroy(&(tree->mutex));
-  free(tree);  
-}
+    // drain the rest of the message
+    while(recv(fd, &byte, 1, 0) > 0);
+    return EOK;
+  }
 
-//------------------------------------------------------------------- 
+  // the graph is in the stream
+  size_t length = count;
 
-void colourNodes(TTree *tree, int colour) {
-  DEBUG(msgt("Colour nodes.", tree))
+  while(count > 0) {
 
-  TNode *node = NULL;
-  TList *L = &(tree->nodes);
-  
-  while(!isEmptyList(L)) {
-  
-    node = popList(L);  
-    lockNode(node);
+    // grow the buffer of the slot
+    if (length == slot->size) {
+      char *buffer = realloc(slot->buffer, 2 * slot->size);
+      if (buffer == NULL) {
+        return EALLOC;
+      }
 
-    if (node->tree == tree) {
-      node->colour = colour;
-      node->tree = NULL;
-      node->entry = NULL;
+      slot->buffer = buffer;
+      slot->size *= 2;
     }
-    
-    unlockNode(node);
+
+    count = recv(fd, slot->buffer + length, slot->size - length, 0);
+    if (count < 0) {
+      return ESOCKET;
+    }
+
+    length += count;
   }
+
+  *data = slot->buffer;
+  *size = length;
+  return EOK;
 }
 
-//------------------------------------------------------------------- MATCHING
+//-------------------------------------------------------------------
+
+int matchRequest(TSlot *slot) {
 
-int inM(TNode *node) {
+  TPool *pool = slot->server->pool;
+  TJob job;
 
-  TEdge *edge = node->edges;     
-  while((edge != NULL) && !(edge->M)) {
-    edge = edge->next;
+  // large graphs are shared by all workers
+  if (slot->graph.m >= SMALLGRAPH) {
+    return findMatchingInPool(pool, &(slot->graph));
   }
-  
-  return (edge != NULL);
-}
 
-//------------------------------------------------------------------- 
+  // small graphs are matched by one worker
+  job.task = &_findMatchingAlone;
+  job.graph = &(slot->graph);
+  job.error = EOK;
 
-void changeM(TEdge *edge) {
+  int error = submitJob(pool, &job);
+  if (error != EOK) {
+    return error;
+  }
 
-  edge->M = !(edge->M);
-  edge->reversed->M = !(edge->reversed->M);
+  waitJobs(pool, &job, 1);
+  return job.error;
 }
 
 //-------------------------------------------------------------------
 
-void processPath(TNode *end) {
-
-  TNode *u, *v;
-  TEdge *uv, *vu;
-    
-  u = end;
+void writeAll(int fd, char *data, size_t size) {
 
-  while (u->entry != NULL) {
+  while(size > 0) {
+    ssize_t count = send(fd, data, size, MSG_NOSIGNAL);
+    if (count <= 0) {
+      break;
+    }
 
-    vu = u->entry;
-    uv = vu->reversed;
-    v  = uv->node;
-    
-    changeM(uv);
-    u = v;
-    
+    data += count;
+    size -= count;
   }
 }
 
-//------------------------------------------------------------------- ADD NODE TO TREE
-
-void _addNodeToTree(TTree *tree, TNode *node, TEdge *edge, int colour) {
-  
-  node->tree = tree;
-  node->entry = edge;
-  node->colour = colour;
-  
-  pushList(&(tree->nodes), node);
-}
-
 //-------------------------------------------------------------------
 
+void handleRequest(TSlot *slot, TClient *client) {
 
-int addNodeToTree(TTree *treeA, TNode *nodeA, TNode *nodeB, TEdge *AB, int M) {
-
-  DEBUG(msgt("Try add node B %d to node A %d.", treeA, nodeB->id, nodeA->id))
-
-  // init
-  int status = OK;
-  int hasPath = 0;
-  int colour = M ? RED : BLUE;  
+  TServer *server = slot->server;
+  char *data = NULL, *response = NULL;
+  size_t size = 0, length = 0;
+  int mapped = 0;
   
-  TTree *treeB = NULL;
+  // receive and load the graph
+  int error = receiveRequest(slot, client->fd, &data, &size, &mapped);
+  if (error == EOK) {
+    error = reloadGraphData(&(slot->graph), data, size);
+  }
   
-  // lock nodes
-  lockNodes(nodeA, nodeB);
-    
-  // lock tree A and check if it has path
-  lockTree(treeA);
-  hasPath = (treeA->status == HASPATH);
-  unlockTree(treeA);
+  if (mapped) {
+    munmap(data, size);
+  }
   
-  // has path
-  if(hasPath) {
-    DEBUG(msgt("PATH: Has path.", treeA))
-    status = PATH;
-  }
-  // same trees
-  else if (nodeA->tree == nodeB->tree) {
-    DEBUG(msgt("IGNORE: Same trees.", treeA))
-    status = IGNORE;
-  }
-  // check matching
-  else if (AB->M != M) {
-    DEBUG(msgt("IGNORE: Wrong type of edge.", treeA))
-    status = IGNORE;  
-  }
-  // APS tree
-  else if (nodeB->colour == GREEN) {
-    DEBUG(msgt("IGNORE: The node %d is in APS tree.", treeA, nodeB->id))
-    status = IGNORE;   
-  }
-  // FREE tree
-  else if (nodeB->colour == WHITE) {
-    DEBUG(msgt("OK: The node %d is free.", treeA, nodeB->id))
-    
-    lockTree(treeA);
-    _addNodeToTree(treeA, nodeB, AB, colour);
-    unlockTree(treeA);
-    
-    status = OK; 
+  // find matching
+  if (error == EOK) {
+    error = matchRequest(slot);
   }
-  // INPROCESS tree - found path
-  else if (nodeB->colour == nodeA->colour) {
-      
-    treeB = nodeB->tree;
-    lockTrees(treeA, treeB);
-    
-    if (treeA->status == INPROCESS && treeB->status == INPROCESS) {
-      DEBUG(msgt("PATH: Found path.", treeA))
-      
-      treeA->status = HASPATH;
-      treeA->pathEnd = nodeA;  
-      treeB->status = HASPATH;
-      treeB->pathEnd = nodeB;
-      changeM(AB);
-      status = PATH;
+
+  // send the response
+  FILE *f = open_memstream(&response, &length);
+  if (f != NULL) {
+
+    if (error == EOK) {
+      printMatching(&(slot->graph), f);
     }
     else {
-      DEBUG(msgt("IGNORE: Tree A is in conflict.", treeA))
-      status = CONFLICT;
+      fprintf(f, "<Error>\n%d\n", error);
     }
-    
-    unlockTree(treeA);
-    unlockTree(treeB);
-  
-  }
-  // INPROCESS tree - conflict
-  else {
-    DEBUG(msgt("IGNORE: Tree A is in conflict.", treeA))
-    status = CONFLICT;      
+
+    fclose(f);
+    writeAll(client->fd, response, length);
+    free(response);
   }
-  
-  unlockNode(nodeA);
-  unlockNode(nodeB);
 
-  DEBUG(msgt("End of add node to tree.", treeA))
-  return status;
-}
+  close(client->fd);
 
-//------------------------------------------------------------------- APPLY APS
+  // record the latency
+  double latency = elapsed(&(client->start));
 
-int _applyAPS(TTree *tree, TQueue *Q, int *ptrStatus) {
+  pthread_mutex_lock(&(server->mutex));
+  server->latencies[server->requests % LATENCIES] = latency;
+  int request = ++(server->requests);
+  pthread_mutex_unlock(&(server->mutex));
 
-  DEBUG(msgt("Apply APS for root %d.", tree, tree->root->id))
+  fprintf(stderr, "REQUEST %d slot=%d error=%d n=%" PRIINDEX " m=%" PRIINDEX " latency=%.0fus\n",
+          request, slot->id, error, slot->graph.n, slot->graph.m, latency);
 
-  int M = 0; 
-  int error = EOK; 
-  int status = OK;
-  int colour = WHITE;
-  
-  TNode *x, *y, *z, *pathEnd = NULL;
-  TEdge *xy, *yz;
+  if (request % 1000 == 0) {
+    printLatency(server, stderr);
+  }
+}
 
-  // insert root into Q
-  error = pushQueue(Q, (void*) tree->root);
-  
-  if (error != EOK)
-    return error;
-  
-  // process the queue
-  while(!isEmptyQueue(Q) && status == OK && error == EOK) {
+//-------------------------------------------------------------------
 
-    // get x
-    x = popQueue(Q);    
-    xy = x->edges;
-    
-    while(xy != NULL && status == OK && error == EOK) {
+void *_runSlot(void *params) {
 
-      // get y
-      y = xy->node;
-      status = addNodeToTree(tree, x, y, xy, 0);
-      
-      // try next edge
-      if (status == IGNORE || status == CONFLICT) {
-        xy = xy->next;
-        status = OK;
-      }      
-      // new y
-      else if (status == OK) {
-        DEBUG(msgt("Added new y=%d.", tree, y->id));      
-        
-        M = 0;      
-        yz = y->edges;
-      
-        while(yz != NULL && status == OK && error == EOK) {
-            
-          // get z
-          z = yz->node;
-          status = addNodeToTree(tree, y, z, yz, 1);
-
-          // try next edge
-          if (status == IGNORE) {
-            yz = yz->next;
-            status = OK;
-          }
-          // node in conflict, try next y
-          else if (status == CONFLICT) {
-            status = OK;
-            yz = NULL;
-            M++;
-          }
-          // new z
-          else if (status == OK) {
-            DEBUG(msgt("Added new z=%d.", tree, z->id));
-            
-            error = pushQueue(Q, (void*) z);
-            M++;
-            break;
-          }
-        }    
-      
-        // found path from y
-        if (status == OK && !M) {  
-          DEBUG(msgt("Found path, y is not in M.", tree))
-          pathEnd = y;
-          status = PATH;
-        }
-      
-        // try next edge xy
-        xy = xy->next;      
-      }
+  TSlot *slot = (TSlot*) params;
+  TServer *server = slot->server;
+  TClient *client = NULL;
+
+  while(1) {
+
+    // wait for an admitted client
+    pthread_mutex_lock(&(server->mutex));
+
+    while(isEmptyQueue(&(server->clients)) && !server->stop) {
+      pthread_cond_wait(&(server->work), &(server->mutex));
     }
-  }
 
-  // process results  
-  lockTree(tree);
-  
-  if (status == PATH) {
-    DEBUG(msgt("Processing path.", tree))
-    
-    if (tree->status == HASPATH) {
-      pathEnd = tree->pathEnd;
+    if (isEmptyQueue(&(server->clients))) {
+      pthread_mutex_unlock(&(server->mutex));
+      break;
     }
 
-    tree->status = HASPATH;
-    unlockTree(tree);
-    
-    processPath(pathEnd);
-    colour = WHITE;
-    status = OK;
-  }
-  else {
-    
-    DEBUG(msgt("Found APS tree.", tree))
-    tree->status = APSTREE;
-    colour = GREEN;
-    status = OK;
-       
-    unlockTree(tree);
+    client = popQueue(&(server->clients));
+    pthread_mutex_unlock(&(server->mutex));
+
+    // handle the request
+    handleRequest(slot, client);
+    free(client);
+
+    pthread_mutex_lock(&(server->mutex));
+    server->admitted--;
+    pthread_mutex_unlock(&(server->mutex));
   }
 
-  // recolour nodes
-  colourNodes(tree, colour);
-  
-  // set status
-  *ptrStatus = status;
-  
-  DEBUG(msgt("End of apply APS.", tree))
-  return error;
+  pthread_exit(0);
 }
 
-int applyAPS(TTree *tree, int *status) {
+//-------------------------------------------------------------------
 
-  TQueue Q;
-  initQueue(&Q);
-    
-  int error = _applyAPS(tree, &Q, status);
+int admitClient(TServer *server, int fd) {
+
+  // create client
+  TClient *client = malloc(sizeof(TClient));
+  if (client == NULL) {
+    return EALLOC;
+  }
+
+  client->fd = fd;
+  clock_gettime(CLOCK_MONOTONIC, &(client->start));
+
+  // admission control
+  pthread_mutex_lock(&(server->mutex));
+
+  int error = (server->admitted < server->limit) ? EOK : ELIMIT;
+
+  if (error == EOK) {
+    error = pushQueue(&(server->clients), (void*) client);
+  }
+
+  if (error == EOK) {
+    server->admitted++;
+    pthread_cond_signal(&(server->work));
+  }
+  else {
+    server->rejected++;
+  }
+
+  pthread_mutex_unlock(&(server->mutex));
+
+  if (error != EOK) {
+    free(client);
+  }
 
-  freeQueue(&Q);
   return error;
 }
 
-//------------------------------------------------------------------- FIND MATCHING
+//-------------------------------------------------------------------
+
+int openSocket(char *path) {
 
-int _findMatching(TGraph *graph, TQueue *Q, TMutex *qmutex, int id) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
 
-  int error = EOK;
-  int status = OK;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+
+  strcpy(addr.sun_path, path);
   
-  while(error == EOK) {
-    
-    // lock the queue
-    DEBUG(msg("Get new root node.", id))
-    pthread_mutex_lock(qmutex);
-    
-    // is queue empty?
-    if(isEmptyQueue(Q)) {
-      DEBUG(msg("Root node queue is empty.", id))
-      pthread_mutex_unlock(qmutex);
-      break;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  unlink(path);
+
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+//-------------------------------------------------------------------
+
+int runServer(char *path, int n, int limit) {
+
+  int error = EOK;
+  TPool pool;
+  TServer server;
+  struct sigaction action;
+  sigset_t signals, old;
+
+  // workers and slots do not handle signals
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, &old);
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &_stopServer;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  // open socket
+  server.fd = openSocket(path);
+  if (server.fd < 0) {
+    return ESOCKET;
+  }
+
+  // init server
+  server.stop = 0;
+  server.limit = limit;
+  server.admitted = 0;
+  server.requests = 0;
+  server.rejected = 0;
+  server.pool = &pool;
+  server.nslots = 0;
+
+  initQueue(&(server.clients));
+  pthread_mutex_init(&(server.mutex), NULL);
+  pthread_cond_init(&(server.work), NULL);
+
+  // the pool and the arenas of slots stay warm between requests
+  error = initPool(&pool, n);
+  int pooled = (error == EOK);
+
+  // only the started slots are joined
+  server.slots = malloc(n * sizeof(TSlot));
+
+  if (server.slots == NULL) {
+    error = EALLOC;
+  }
+
+  for (int i = 0; error == EOK && i < n; i++) {
+
+    TSlot *slot = &(server.slots[i]);
+    slot->id = i + 1;
+    slot->server = &server;
+    slot->size = CHUNKSIZE;
+    slot->buffer = malloc(slot->size);
+    initGraph(&(slot->graph), 0, 0);
+
+    if (slot->buffer == NULL
+        || pthread_create(&(slot->thread), NULL, &_runSlot, (void *) slot) != 0) {
+      free(slot->buffer);
+      freeGraph(&(slot->graph));
+      error = EALLOC;
     }
-    
     else {
-    
-      // get root node
-      TNode *node = popQueue(Q);
-      
-      // unlock the queue
-      pthread_mutex_unlock(qmutex);
-      
-      // lock the node
-      lockNode(node);
-
-      if (node->colour == WHITE) {
-        if (!inM(node)) {
-        
-          // create tree
-          TTree *tree = createTree(graph);
-          if (tree == NULL) {
-            unlockNode(node);
-            return EALLOC;
-          }
-          
-          // lock the tree
-          lockTree(tree);
-      
-          tree->root = node; 
-          tree->owner = id;
-          
-          _addNodeToTree(tree, node, NULL, RED);
-          
-          // unlock the tree     
-          unlockTree(tree);
-          
-          // unlock the node
-          unlockNode(node);
-      
-          // find augmenting path
-          error = applyAPS(tree, &status);      
-          
-          // free nodes in tree and tree     
-          freeTree(tree);     
-        }
-        else {
-          DEBUG(msg("Root node %d in M.", id, node->id))
-          unlockNode(node);        
-          status = OK;
-        }
-      }
-      else if (node->colour == GREEN) {
-        DEBUG(msg("Root node %d in APS tree.", id, node->id))
-        unlockNode(node);
-        status = OK;
+      server.nslots = i + 1;
+    }
+  }
+
+  if (error == EOK) {
+    fprintf(stderr, "SERVER %s workers=%d limit=%d\n", path, n, limit);
+  }
+
+  // accept clients until a signal comes
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  while(error == EOK && !serverStop) {
+
+    int fd = accept(server.fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      error = ESOCKET;
+      break;
+    }
+
+    // bound the time a client can hold a slot
+    struct timeval timeout = { RECVTIMEOUT, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if (admitClient(&server, fd) != EOK) {
+      char busy[32];
+      int length = sprintf(busy, "<Error>\n%d\n", ELIMIT);
+      writeAll(fd, busy, length);
+      close(fd);
+    }
+  }
+
+  // stop slots after the admitted requests
+  pthread_mutex_lock(&(server.mutex));
+  server.stop = 1;
+  pthread_cond_broadcast(&(server.work));
+  pthread_mutex_unlock(&(server.mutex));
+
+  for (int i = 0; i < server.nslots; i++) {
+    pthread_join(server.slots[i].thread, NULL);
+    free(server.slots[i].buffer);
+    freeGraph(&(server.slots[i].graph));
+  }
+
+  printLatency(&server, stderr);
+
+  // free server
+  if (pooled) {
+    freePool(&pool);
+  }
+
+  free(server.slots);
+  freeQueue(&(server.clients));
+  pthread_mutex_destroy(&(server.mutex));
+  pthread_cond_destroy(&(server.work));
+  close(server.fd);
+  unlink(path);
+
+  return error;
+}
+
+//------------------------------------------------------------------- CLIENT
+
+int connectSocket(char *path) {
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+//-------------------------------------------------------------------
+
+int sendDescriptor(int fd, int memfd) {
+
+  char byte = 0;
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov;
+  struct msghdr msg;
+
+  iov.iov_base = &byte;
+  iov.iov_len = 1;
+
+  memset(&msg, 0, sizeof(msg));
+  memset(control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+  return (sendmsg(fd, &msg, MSG_NOSIGNAL) == 1) ? EOK : ESOCKET;
+}
+
+//-------------------------------------------------------------------
+
+int runClient(char *path, char *fname, int memfd) {
+
+  char buffer[CHUNKSIZE];
+  size_t count = 0;
+  int error = EOK;
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // connect
+  int fd = connectSocket(path);
+  if (fd < 0) {
+    fclose(f);
+    return ESOCKET;
+  }
+
+  // pass the graph in a memory file
+  if (memfd) {
+
+    int mfd = memfd_create("graph", 0);
+    if (mfd < 0) {
+      error = EALLOC;
+    }
+
+    while(error == EOK && (count = fread(buffer, 1, CHUNKSIZE, f)) > 0) {
+      if (write(mfd, buffer, count) != (ssize_t) count) {
+        error = EALLOC;
       }
-      else {
-        DEBUG(msg("Root node %d is processed.", id, node->id))
-        unlockNode(node);
-        status = ABORT;
+    }
+
+    if (error == EOK) {
+      error = sendDescriptor(fd, mfd);
+    }
+
+    if (mfd >= 0) {
+      close(mfd);
+    }
+  }
+  // or in the stream
+  else {
+    while((count = fread(buffer, 1, CHUNKSIZE, f)) > 0) {
+      writeAll(fd, buffer, count);
+    }
+  }
+
+  fclose(f);
+  shutdown(fd, SHUT_WR);
+
+  // print the response
+  ssize_t received = 0;
+  while((received = recv(fd, buffer, CHUNKSIZE, 0)) > 0) {
+    fwrite(buffer, 1, received, stdout);
+  }
+
+  close(fd);
+  return error;
+}
+
+//------------------------------------------------------------------- MATCHING
+
+int runMatching(char *fname, int n, char *init, char *snapshot, int interval, int resume, TLimits *limits,
+                int verify, int format, char *stats, char *trace, int counters) {
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // hardware counters of the phases
+  TPerf perf;
+  if (counters) {
+    initPerf(&perf);
+    beginPerf(&perf, NULL);
+  }
+
+  // load graph
+  TGraph graph;
+  int error = loadGraph(&graph, f);
+  fclose(f);
+
+  if (counters && error == EOK) {
+    endPerf(&perf, NULL, LOAD, (uint64_t) graph.m);
+  }
+
+  // print graph
+  DEBUG(printGraph(&graph, stderr))
+
+  // seed the matching, a snapshot has its own
+  if (error == EOK && init != NULL && !resume) {
+
+    FILE *m = fopen(init, "r");
+    error = (m != NULL) ? loadMatching(&graph, m) : EFILE;
+    if (m != NULL) fclose(m);
+  }
+
+  // find matching
+  TCertificate cert = {0};
+  TDecomposition dm = {0};
+
+  if (error == EOK) {
+
+    TPool pool;
+    error = initPool(&pool, n);
+
+    if (error == EOK && trace != NULL) {
+      error = initTrace(&pool, TRACE_EVENTS);
+    }
+
+    if (error == EOK && counters) {
+      beginPerf(&perf, &pool);
+    }
+
+    if (error == EOK && snapshot != NULL) {
+      error = findMatchingCheckpoint(&pool, &graph, snapshot, interval, resume);
+    }
+    else if (error == EOK && limits != NULL) {
+      error = findMatchingBounded(&pool, &graph, limits);
+    }
+    else if (error == EOK) {
+      error = findMatchingInPool(&pool, &graph);
+    }
+
+    // per edge scanned by the workers
+    if (error == EOK && counters) {
+
+      TStats total;
+      mergeStats(&pool, &total);
+      endPerf(&perf, &pool, MATCH, total.edges);
+      beginPerf(&perf, &pool);
+    }
+
+    // print matching, the workers format the chunks
+    if (error == EOK) {
+      error = writeMatching(&pool, &graph, format, stdout);
+    }
+
+    if (error == EOK && counters) {
+      endPerf(&perf, &pool, OUTPUT, (uint64_t) graph.m);
+    }
+
+    // counters of the workers
+    if (error == EOK && stats != NULL) {
+
+      FILE *s = fopen(stats, "w");
+      if (s != NULL) {
+        printStats(&pool, s);
       }
 
-      // return node to queue
-      if (status == ABORT) {
-        DEBUG(msg("Return node %d to root node queue.", id, node->id))
-        pthread_mutex_lock(qmutex);
-        error = pushQueue(Q, (void*) node);
-        pthread_mutex_unlock(qmutex);    
+      error = (s != NULL && fclose(s) == 0) ? EOK : EFILE;
+    }
+
+    // timeline of the workers
+    if (error == EOK && trace != NULL) {
+
+      FILE *t = fopen(trace, "w");
+      error = (t != NULL) ? writeTrace(&pool, t) : EFILE;
+
+      if (t != NULL && fclose(t) != 0) {
+        error = EFILE;
       }
-    }  
+    }
+
+    // prove the matching is maximum
+    if (error == EOK && verify) {
+      error = verifyMatching(&pool, &graph, &cert);
+    }
+
+    // the blocks reuse the sides and the cover of the certificate
+    if (error == EOK && verify == DECOMPOSE && cert.verified) {
+      error = decomposeMatching(&pool, &graph, &cert, &dm);
+    }
+
+    // the table of counted locks, empty without LOCKSTATS
+    printLocks(&pool, stderr);
+    freePool(&pool);
   }
 
+  if (counters) {
+    if (error == EOK) printPerf(&perf, stderr);
+    freePerf(&perf);
+  }
+
+  if (error == EOK && verify) {
+    fprintf(stdout, "\n");
+    printCertificate(&cert, stdout);
+    error = cert.verified ? EOK : EINTERN;
+  }
+
+  if (error == EOK && verify == DECOMPOSE) {
+    fprintf(stdout, "\n");
+    error = printDecomposition(&dm, stdout);
+  }
+
+  freeDecomposition(&dm);
+  freeCertificate(&cert);
+  freeGraph(&graph);
   return error;
 }
 
+//------------------------------------------------------------------- BENCH
+
+int runBench(char *fname, int n, int trials) {
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // the graph is loaded once
+  TGraph graph;
+  TBench bench;
+  uint64_t start = traceClock();
+  int error = loadGraph(&graph, f);
+  fclose(f);
+
+  if (error != EOK) {
+    return error;
+  }
+
+  error = initBench(&bench, trials);
+  addSample(&bench, LOAD, traceClock() - start);
+
+  // warm trials of the same pool
+  if (error == EOK) {
+
+    TPool pool;
+    error = initPool(&pool, n);
+
+    if (error == EOK) {
+      error = benchMatching(&pool, &graph, &bench);
+      freePool(&pool);
+    }
+  }
+
+  if (error == EOK) {
+    printBench(&bench, "parallel", fname, n, stdout);
+  }
+
+  freeBench(&bench);
+  freeGraph(&graph);
+  return error;
+}
+
+//------------------------------------------------------------------- SWEEP
+
+#define MAXCOUNTS 256
+
+int parseCounts(char *spec, int *counts) {
+
+  int size = 0;
+
+  // items 4 or ranges 1-15 separated by commas
+  for (char *item = strtok(spec, ","); item != NULL; item = strtok(NULL, ",")) {
+
+    int first = 0, last = 0, read = 0;
+
+    if (sscanf(item, "%d-%d%n", &first, &last, &read) != 2 || item[read] != '\0') {
+
+      if (sscanf(item, "%d%n", &first, &read) != 1 || item[read] != '\0') {
+        return -1;
+      }
+
+      last = first;
+    }
+
+    for (int i = first; i <= last; i++) {
+
+      if (size == MAXCOUNTS) {
+        return -1;
+      }
+
+      counts[size++] = i;
+    }
+  }
+
+  return size;
+}
+
 //-------------------------------------------------------------------
 
-void* _findMatchingParallel(void *params) {
+int setProcessors(int proc) {
 
-  TThreadData *data = (TThreadData*) params;
-  data->error = _findMatching(data->graph, data->queue, data->mutex, data->id);
+  // threads of the next pool inherit the set 0-proc
+  cpu_set_t set;
+  CPU_ZERO(&set);
 
-  if (data->error != EOK) {
-    fprintf(stderr, "ERROR %d\n", data->error);
+  for (int i = 0; i <= proc; i++) {
+    CPU_SET(i, &set);
   }
 
-  pthread_exit(0);
+  return (sched_setaffinity(0, sizeof(set), &set) == 0) ? EOK : EPARAM;
 }
 
 //-------------------------------------------------------------------
 
-int findMatching(TGraph *graph, int n) {
+int runSweep(char *fname, char *threadsSpec, char *procsSpec, int trials) {
 
-  // init queue
-  int error = EOK;
-  
-  // init processes
-  TThread *threads = malloc(n * sizeof(TThread));
-  TThreadData *data = malloc(n * sizeof(TThreadData));
-  
-  if (threads == NULL) {
-    free(threads);
-    error = EALLOC;
+  int threads[MAXCOUNTS], procs[MAXCOUNTS];
+  int nthreads = parseCounts(threadsSpec, threads);
+  int nprocs = 1;
+
+  // without a set the processors stay as they are
+  procs[0] = -1;
+
+  if (procsSpec != NULL) {
+    nprocs = parseCounts(procsSpec, procs);
   }
-  
-  if(data == NULL) {
-    free(data);
-    error = EALLOC;
+
+  if (nthreads <= 0 || nprocs <= 0) {
+    return EPARAM;
   }
-  
+
+  for (int i = 0; i < nthreads; i++) {
+    if (threads[i] <= 0) return EPARAM;
+  }
+
+  for (int i = 0; i < nprocs; i++) {
+    if (procs[i] < 0 && procsSpec != NULL) return EPARAM;
+  }
+
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  // the graph is loaded once
+  TGraph graph;
+  int error = loadGraph(&graph, f);
+  fclose(f);
+
   if (error != EOK) {
     return error;
   }
-  
-  // init queue
-  TQueue Q;
-  initQueue(&Q);
-  
-  TMutex qmutex;
-  pthread_mutex_init(&(qmutex), NULL);
-  
-  for (int i = 0; i < graph->n; i++) {
-    error = pushQueue(&Q, (void*) &(graph->nodes[i]));
-    
-    if (error != EOK) {
-      freeQueue(&Q);
-      free(threads);
-      free(data);
-      return error;
+
+  // the sequence engine is the base of the speedup
+  TBench bench;
+  error = initBench(&bench, trials);
+
+  if (error == EOK) {
+    error = benchMatching(NULL, &graph, &bench);
+  }
+
+  double base = medianBench(&bench, MATCH) / 1e9;
+  TIndex M = bench.M;
+  int consistent = bench.stable;
+  freeBench(&bench);
+
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+  // the rows of test/experiment.sh with speedup, efficiency and |M|
+  if (error == EOK) {
+    printf("SEQUENCE;%" PRIINDEX ";%" PRIINDEX ";1;1;%.6f;1.000;1.000;%" PRIINDEX ";\n",
+           graph.n, graph.m, base, M);
+  }
+
+  for (int p = 0; p < nprocs && error == EOK; p++) {
+
+    int proc = (procs[p] >= 0) ? procs[p] : (int) online - 1;
+
+    if (procs[p] >= 0) {
+      error = setProcessors(procs[p]);
+    }
+
+    for (int t = 0; t < nthreads && error == EOK; t++) {
+
+      TPool pool;
+      error = initBench(&bench, trials);
+
+      if (error == EOK) {
+        error = initPool(&pool, threads[t]);
+
+        if (error == EOK) {
+          error = benchMatching(&pool, &graph, &bench);
+          freePool(&pool);
+        }
+      }
+
+      if (error == EOK) {
+
+        double time = medianBench(&bench, MATCH) / 1e9;
+        double speedup = (time > 0) ? base / time : 0;
+        int parallel = (threads[t] < proc + 1) ? threads[t] : proc + 1;
+
+        printf("PARALLEL;%" PRIINDEX ";%" PRIINDEX ";%d;%d;%.6f;%.3f;%.3f;%" PRIINDEX ";\n",
+               graph.n, graph.m, proc, threads[t], time, speedup, speedup / parallel, bench.M);
+        fflush(stdout);
+
+        // every run must agree on the size
+        consistent &= bench.stable && bench.M == M;
+      }
+
+      freeBench(&bench);
     }
   }
-  
-  // find matching parallel
-  for (int i = 0; i < n; i++) {
-
-    // prepare data
-    data[i].id = i + 1;
-    data[i].graph = graph;
-    data[i].queue = &Q;
-    data[i].mutex = &qmutex;
-    data[i].error = EOK;  
-    
-    // create thread
-    pthread_create (&threads[i], NULL, &_findMatchingParallel, (void *) &data[i]);  
+
+  freeGraph(&graph);
+
+  if (error == EOK && !consistent) {
+    fprintf(stderr, "matching sizes differ\n");
+    error = EINTERN;
   }
 
-  // join processes
-  for (int i = 0; i < n; i++) {
-    pthread_join(threads[i], NULL);
-    if(error == EOK) error = data[i].error;
+  return error;
+}
+
+//------------------------------------------------------------------- VERIFY
+
+int runVerify(char *fname, int n, char *mname, int verify) {
+
+  // load graph and matching
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
+
+  TGraph graph;
+  int error = loadGraph(&graph, f);
+  fclose(f);
+
+  if (error == EOK) {
+
+    FILE *m = fopen(mname, "r");
+    error = (m != NULL) ? loadMatching(&graph, m) : EFILE;
+    if (m != NULL) fclose(m);
+  }
+
+  // check the matching as it is
+  TCertificate cert = {0};
+  TDecomposition dm = {0};
+
+  if (error == EOK) {
+
+    TPool pool;
+    error = initPool(&pool, n);
+
+    if (error == EOK) {
+      error = verifyMatching(&pool, &graph, &cert);
+    }
+
+    if (error == EOK && verify == DECOMPOSE && cert.verified) {
+      error = decomposeMatching(&pool, &graph, &cert, &dm);
+    }
+
+    freePool(&pool);
+  }
+
+  if (error == EOK) {
+    printCertificate(&cert, stdout);
+    error = cert.verified ? EOK : EINPUT;
+  }
+
+  if (error == EOK && verify == DECOMPOSE) {
+    fprintf(stdout, "\n");
+    error = printDecomposition(&dm, stdout);
+  }
+
+  freeDecomposition(&dm);
+  freeCertificate(&cert);
+  freeGraph(&graph);
+  return error;
+}
+
+//------------------------------------------------------------------- DYNAMIC
+
+#define UPDATESIZE 1024
+
+int nextUpdates(FILE *f, TUpdate **updates, int *size, int *count) {
+
+  // read lines "+ A B" and "- A B" until an empty line
+  char line[MAXPATH];
+  *count = 0;
+
+  while (fgets(line, MAXPATH, f) != NULL) {
+
+    char op;
+    TIndex idA, idB;
+
+    if (sscanf(line, " %c %" SCNINDEX " %" SCNINDEX, &op, &idA, &idB) != 3) {
+      if (*count > 0) break;
+      continue;
+    }
+
+    if (op != '+' && op != '-') {
+      return EINPUT;
+    }
+
+    // enlarge the buffer of updates
+    if (*count == *size) {
+      TUpdate *buffer = realloc(*updates, 2 * (*size) * sizeof(TUpdate));
+      if (buffer == NULL) {
+        return EALLOC;
+      }
+
+      *updates = buffer;
+      *size *= 2;
+    }
+
+    TUpdate *update = &((*updates)[(*count)++]);
+    update->op = (op == '+') ? INSERT : DELETE;
+    update->idA = idA;
+    update->idB = idB;
   }
 
-  free(threads);
-  free(data);  
-  freeQueue(&Q);
   return EOK;
 }
 
+//-------------------------------------------------------------------
+
+int runDynamic(char *fname, char *uname, int n) {
+
+  // open files
+  FILE *f = fopen(fname, "r");
+  FILE *u = fopen(uname, "r");
+
+  if (f == NULL || u == NULL) {
+    if (f != NULL) fclose(f);
+    if (u != NULL) fclose(u);
+    return EFILE;
+  }
+
+  int size = UPDATESIZE;
+  TUpdate *updates = malloc(size * sizeof(TUpdate));
+
+  // match the graph once
+  TGraph graph;
+  TPool pool;
+
+  int error = loadGraph(&graph, f);
+  int status = initPool(&pool, n);
+
+  if (updates == NULL) {
+    error = EALLOC;
+  }
+  if (error == EOK) {
+    error = status;
+  }
+  if (error == EOK) {
+    error = findMatchingInPool(&pool, &graph);
+  }
+
+  // repair the matching after each batch of updates
+  int count = 0;
+
+  while (error == EOK && (error = nextUpdates(u, &updates, &size, &count)) == EOK && count > 0) {
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int rounds = 0;
+    int rematched = 0;
+    error = updateMatching(&pool, &graph, updates, count, &rounds, &rematched);
+
+    int inserts = 0;
+    for (int i = 0; i < count; i++) {
+      inserts += (updates[i].op == INSERT);
+    }
+
+    printf("<Update>\ninserts %d\ndeletes %d\nrounds %d\nrematched %d\ntime %.1f\n\n",
+           inserts, count - inserts, rounds, rematched, elapsed(&start));
+  }
+
+  if (error == EOK) {
+    printMatching(&graph, stdout);
+  }
+
+  freePool(&pool);
+  freeGraph(&graph);
+  free(updates);
+  fclose(f);
+  fclose(u);
+  return error;
+}
+
+//------------------------------------------------------------------- WIDE GRAPHS
+
+void runWide(char *argv[]) {
+
+#ifndef INDEX64
+  // the graph needs 64-bit ids, run the same command in matching64
+  char path[MAXPATH];
+
+  if (snprintf(path, MAXPATH, "%s64", argv[0]) < MAXPATH) {
+    argv[0] = path;
+    execvp(path, argv);
+  }
+#else
+  (void) argv;
+#endif
+}
+
 //------------------------------------------------------------------- MAIN FUNCTION
 
 int main (int argc, char *argv[])
@@ -991,37 +1393,161 @@ int main (int argc, char *argv[])
   int error = EOK;
   
   // check params
-  if (argc == 3) {
-  
+  if ((argc == 4 || argc == 5) && strcmp(argv[1], "--server") == 0) {
+
+    // get number of processes and admitted requests
+    int n = atoi(argv[3]);
+    int limit = (argc == 5) ? atoi(argv[4]) : 4 * n;
+    
+    if (n > 0 && limit > 0) {
+
+      // serve requests until a signal comes
+      error = runServer(argv[2], n, limit);
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+  else if (argc == 4 && (strcmp(argv[1], "--client") == 0 || strcmp(argv[1], "--client-memfd") == 0)) {
+
+    // send the graph to the server
+    error = runClient(argv[2], argv[3], strcmp(argv[1], "--client-memfd") == 0);
+  }
+  else if (argc == 5 && strcmp(argv[1], "--dynamic") == 0) {
+
     // get number of processes
-    int n = atoi(argv[2]);
+    int n = atoi(argv[4]);
     if (n > 0) {
+
+      // match the graph and repair it after the updates
+      error = runDynamic(argv[2], argv[3], n);
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+  else if ((argc == 4 || argc == 5) && strcmp(argv[1], "--bench") == 0) {
+
+    // get number of processes and trials
+    int n = atoi(argv[3]);
+    int trials = (argc == 5) ? atoi(argv[4]) : BENCH_TRIALS;
+
+    if (n > 0 && trials > 0) {
+
+      // time the phases of warm runs
+      error = runBench(argv[2], n, trials);
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+  else if (argc >= 4 && argc <= 6 && strcmp(argv[1], "--sweep") == 0) {
+
+    // thread counts, last processors of the sets and trials
+    char *procs = (argc >= 5 && strcmp(argv[4], "-") != 0) ? argv[4] : NULL;
+    int trials = (argc == 6) ? atoi(argv[5]) : BENCH_TRIALS;
+
+    // one loaded graph for all runs
+    error = (trials > 0) ? runSweep(argv[2], argv[3], procs, trials) : EPARAM;
+  }
+  else if (argc == 4 && (strcmp(argv[1], "--batch") == 0 || strcmp(argv[1], "--manifest") == 0)) {
+
+    // get number of processes
+    int n = atoi(argv[3]);
+    if (n > 0) {
+
+      // match all graphs of the batch
+      error = runBatch(argv[2], strcmp(argv[1], "--manifest") == 0, n);
+    }
+    else {
+      error = EPARAM;
+    }
+  }
+  else if (argc >= 3 && argv[1][0] != '-') {
   
-      // open file
-      FILE *f = fopen(argv[1], "r");
-      if (f != NULL) {
-  
-        // load graph
-        TGraph graph;      
-        error = loadGraph(&graph, f);
-        if (error == EOK) {
-      
-          // print graph
-          DEBUG(printGraph(&graph, stderr))
-        
-          // find matchinf
-          error = findMatching(&graph, n);
-          if (error == EOK) {
-        
-            // print matching
-            printMatching(&graph, stdout);
-          }
-        }    
-        freeGraph(&graph);
-        fclose(f);
+    // get number of processes and options
+    int n = atoi(argv[2]);
+    char *init = NULL;
+    char *snapshot = NULL;
+    int interval = 0;
+    int resume = 0;
+
+    // the time budget counts from the start
+    struct timespec deadline;
+    TLimits limits = {NULL, 0, 1};
+    int bounded = 0;
+
+    // verify the result or a matching file
+    int verify = NOCHECK;
+    char *check = NULL;
+    int format = TEXT;
+    char *stats = NULL;
+    char *trace = NULL;
+    int counters = 0;
+
+    for (int i = 3; i < argc && error == EOK; i++) {
+
+      if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+        init = argv[++i];
+      }
+      else if (strcmp(argv[i], "--checkpoint") == 0 && i + 2 < argc) {
+        snapshot = argv[++i];
+        interval = atoi(argv[++i]);
+      }
+      else if (strcmp(argv[i], "--resume") == 0) {
+        resume = 1;
+      }
+      else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+        stats = argv[++i];
+      }
+      else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+        trace = argv[++i];
+      }
+      else if (strcmp(argv[i], "--counters") == 0) {
+        counters = 1;
+      }
+      else if (strcmp(argv[i], "--binary") == 0) {
+        format = BINARY;
+      }
+      else if (strcmp(argv[i], "--quiet") == 0) {
+        format = QUIET;
+      }
+      else if (strcmp(argv[i], "--verify") == 0 || strcmp(argv[i], "--decompose") == 0) {
+        verify = (strcmp(argv[i], "--verify") == 0) ? VERIFY : DECOMPOSE;
+        if (i + 1 < argc && argv[i + 1][0] != '-') check = argv[++i];
+      }
+      else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc) {
+        initDeadline(&deadline, atof(argv[++i]));
+        limits.deadline = &deadline;
+        bounded = 1;
+      }
+      else if (strcmp(argv[i], "--max-path-length") == 0 && i + 1 < argc) {
+        limits.length = atoi(argv[++i]);
+        bounded = 1;
+
+        if (limits.length <= 0) {
+          error = EPARAM;
+        }
       }
       else {
-        error = EFILE;
+        error = EPARAM;
+      }
+    }
+
+    if (n > 0 && error == EOK && check != NULL
+        && init == NULL && snapshot == NULL && !resume && !bounded) {
+
+      // prove a matching of an earlier run
+      error = runVerify(argv[1], n, check, verify);
+    }
+    else if (n > 0 && error == EOK && (snapshot != NULL || !resume)
+        && !(bounded && snapshot != NULL) && check == NULL && !(format == BINARY && verify)) {
+
+      // find matching
+      error = runMatching(argv[1], n, init, snapshot, interval, resume, bounded ? &limits : NULL, verify, format, stats, trace, counters);
+
+      if (error == EINDEX) {
+        runWide(argv);
       }
     }
     else {
@@ -0,0 +1,448 @@
+/*
+ * Project: GAL 2014 - Python bindings of libmatching
+ * Authors: Vendula Poncova, xponco00
+ *          Chernikava Alena, xcerni0700
+ * Date:    4.12.2014
+ *
+ * Edges are read directly from any C-contiguous buffer of int32 pairs
+ * (for example a NumPy array of shape (m, 2)) and mates are returned
+ * as a NumPy int32 array viewing the result buffer. The GIL is released
+ * while the graph is built and matched.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "matching.h"
+
+// buffers of int32 are passed as TIndex, build with libmatching.a only
+typedef char IndexIsInt[(sizeof(TIndex) == sizeof(int)) ? 1 : -1];
+
+//------------------------------------------------------------------- TYPES
+
+typedef struct {
+  PyObject_HEAD
+  TGraph *graph;
+  int busy;
+} GraphObject;
+
+static PyObject *numpy = NULL;
+
+//------------------------------------------------------------------- ERRORS
+
+static PyObject *raiseError(int error) {
+
+  switch (error) {
+    case EALLOC:
+      return PyErr_NoMemory();
+    case EPARAM:
+    case EINPUT:
+      PyErr_Format(PyExc_ValueError, "invalid graph or parameters (error %d)", error);
+      return NULL;
+    case EFILE:
+      PyErr_Format(PyExc_OSError, "cannot open the graph file (error %d)", error);
+      return NULL;
+    case EINDEX:
+      PyErr_Format(PyExc_OverflowError, "the graph needs 64-bit node ids (error %d)", error);
+      return NULL;
+    default:
+      PyErr_Format(PyExc_RuntimeError, "matching failed (error %d)", error);
+      return NULL;
+  }
+}
+
+//-------------------------------------------------------------------
+
+static int parseEngine(const char *name, int *engine) {
+
+  if (strcmp(name, "parallel") == 0) {
+    *engine = PARALLEL;
+  }
+  else if (strcmp(name, "sequence") == 0) {
+    *engine = SEQUENCE;
+  }
+  else {
+    PyErr_Format(PyExc_ValueError, "unknown engine '%s'", name);
+    return -1;
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int acquireGraph(GraphObject *self) {
+
+  // the graph is used without the GIL
+  if (self->busy) {
+    PyErr_SetString(PyExc_RuntimeError, "the graph is used by another thread");
+    return -1;
+  }
+
+  self->busy = 1;
+  return 0;
+}
+
+//------------------------------------------------------------------- EDGES
+
+static int getEdgeBuffer(PyObject *edges, Py_buffer *view, int *m) {
+
+  if (PyObject_GetBuffer(edges, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+    return -1;
+  }
+
+  // the buffer has to hold native int32 pairs
+  const char *format = (view->format != NULL) ? view->format : "B";
+  int native = (strcmp(format, "i") == 0 || strcmp(format, "=i") == 0 || strcmp(format, "@i") == 0
+                || (strcmp(format, "<i") == 0 && PY_LITTLE_ENDIAN)
+                || (strcmp(format, "l") == 0 && sizeof(long) == sizeof(int)));
+
+  if (!native || view->itemsize != sizeof(int)) {
+    PyErr_SetString(PyExc_TypeError, "edges must be a contiguous int32 array");
+    PyBuffer_Release(view);
+    return -1;
+  }
+
+  Py_ssize_t count = view->len / view->itemsize;
+  if (count % 2 != 0 || (view->ndim == 2 && view->shape[1] != 2) || count / 2 > INT_MAX) {
+    PyErr_SetString(PyExc_ValueError, "edges must be pairs of node ids, shape (m, 2)");
+    PyBuffer_Release(view);
+    return -1;
+  }
+
+  *m = (int) (count / 2);
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static int setEdges(GraphObject *self, int n, PyObject *edges) {
+
+  Py_buffer view;
+  int m = 0, error = EOK;
+
+  if (getEdgeBuffer(edges, &view, &m) != 0) {
+    return -1;
+  }
+
+  if (acquireGraph(self) != 0) {
+    PyBuffer_Release(&view);
+    return -1;
+  }
+
+  // build the graph directly from the buffer
+  Py_BEGIN_ALLOW_THREADS
+  error = setGraphFromArrays(self->graph, n, m, (const TIndex*) view.buf);
+  Py_END_ALLOW_THREADS
+
+  self->busy = 0;
+  PyBuffer_Release(&view);
+
+  if (error != EOK) {
+    raiseError(error);
+    return -1;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------- MATES
+
+static PyObject *matchAndGetMates(GraphObject *self, int engine, int threads) {
+
+  int n = getNodes(self->graph), error = EOK;
+
+  // the result buffer is owned by the returned array
+  PyObject *buffer = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) n * sizeof(int));
+  if (buffer == NULL) {
+    return NULL;
+  }
+
+  if (acquireGraph(self) != 0) {
+    Py_DECREF(buffer);
+    return NULL;
+  }
+
+  TIndex *mates = (TIndex*) PyByteArray_AS_STRING(buffer);
+
+  Py_BEGIN_ALLOW_THREADS
+  error = matchGraph(self->graph, engine, threads);
+  if (error == EOK) {
+    getMates(self->graph, mates);
+  }
+  Py_END_ALLOW_THREADS
+
+  self->busy = 0;
+
+  if (error != EOK) {
+    Py_DECREF(buffer);
+    return raiseError(error);
+  }
+
+  // view the buffer as numpy.int32 without copying
+  PyObject *result = NULL;
+
+  if (numpy != NULL) {
+    result = PyObject_CallMethod(numpy, "frombuffer", "Os", buffer, "int32");
+  }
+  else {
+    PyObject *view = PyMemoryView_FromObject(buffer);
+    result = (view != NULL) ? PyObject_CallMethod(view, "cast", "s", "i") : NULL;
+    Py_XDECREF(view);
+  }
+
+  Py_DECREF(buffer);
+  return result;
+}
+
+//------------------------------------------------------------------- GRAPH
+
+static int Graph_init(GraphObject *self, PyObject *args, PyObject *kwds) {
+
+  static char *keywords[] = {"n", "edges", NULL};
+  PyObject *edges = NULL;
+  int n = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iO", keywords, &n, &edges)) {
+    return -1;
+  }
+
+  if (self->graph == NULL) {
+    self->graph = createGraph(0, 0);
+    if (self->graph == NULL) {
+      PyErr_NoMemory();
+      return -1;
+    }
+  }
+
+  if (edges != NULL) {
+    return setEdges(self, n, edges);
+  }
+
+  // the graph may be matched by another thread
+  if (acquireGraph(self) != 0) {
+    return -1;
+  }
+
+  int error = setGraphFromArrays(self->graph, n, 0, NULL);
+  self->busy = 0;
+
+  if (error != EOK) {
+    raiseError(error);
+    return -1;
+  }
+
+  return 0;
+}
+
+//-------------------------------------------------------------------
+
+static void Graph_dealloc(GraphObject *self) {
+
+  destroyGraph(self->graph);
+  Py_TYPE(self)->tp_free((PyObject*) self);
+}
+
+//-------------------------------------------------------------------
+
+static PyObject *Graph_set_edges(GraphObject *self, PyObject *args) {
+
+  PyObject *edges = NULL;
+  int n = 0;
+
+  if (!PyArg_ParseTuple(args, "iO", &n, &edges)) {
+    return NULL;
+  }
+
+  if (setEdges(self, n, edges) != 0) {
+    return NULL;
+  }
+
+  Py_RETURN_NONE;
+}
+
+//-------------------------------------------------------------------
+
+static PyObject *Graph_read(GraphObject *self, PyObject *args) {
+
+  const char *fname = NULL;
+  int error = EOK;
+
+  if (!PyArg_ParseTuple(args, "s", &fname)) {
+    return NULL;
+  }
+
+  if (acquireGraph(self) != 0) {
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  error = readGraph(self->graph, fname);
+  Py_END_ALLOW_THREADS
+
+  self->busy = 0;
+
+  if (error != EOK) {
+    return raiseError(error);
+  }
+
+  Py_RETURN_NONE;
+}
+
+//-------------------------------------------------------------------
+
+static PyObject *Graph_match(GraphObject *self, PyObject *args, PyObject *kwds) {
+
+  static char *keywords[] = {"threads", "engine", NULL};
+  const char *name = "parallel";
+  int threads = 1, engine = PARALLEL;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|is", keywords, &threads, &name)) {
+    return NULL;
+  }
+
+  if (parseEngine(name, &engine) != 0) {
+    return NULL;
+  }
+
+  return matchAndGetMates(self, engine, threads);
+}
+
+//-------------------------------------------------------------------
+
+static PyObject *Graph_reset(GraphObject *self, PyObject *Py_UNUSED(ignored)) {
+
+  if (acquireGraph(self) != 0) {
+    return NULL;
+  }
+
+  resetMatching(self->graph);
+  self->busy = 0;
+
+  Py_RETURN_NONE;
+}
+
+//-------------------------------------------------------------------
+
+static PyObject *Graph_get_nodes(GraphObject *self, void *closure) {
+  (void) closure;
+  return PyLong_FromLong(getNodes(self->graph));
+}
+
+static PyObject *Graph_get_edges(GraphObject *self, void *closure) {
+  (void) closure;
+  return PyLong_FromLong(getEdges(self->graph));
+}
+
+//-------------------------------------------------------------------
+
+static PyMethodDef Graph_methods[] = {
+  {"set_edges", (PyCFunction) Graph_set_edges, METH_VARARGS,
+   "set_edges(n, edges)\n\nReplace the graph, edges is an int32 buffer of shape (m, 2)."},
+  {"read", (PyCFunction) Graph_read, METH_VARARGS,
+   "read(fname)\n\nReplace the graph with a text or binary graph file."},
+  {"match", (PyCFunction)(void(*)(void)) Graph_match, METH_VARARGS | METH_KEYWORDS,
+   "match(threads=1, engine='parallel')\n\nExtend the matching to a maximum one, return mates."},
+  {"reset", (PyCFunction) Graph_reset, METH_NOARGS,
+   "reset()\n\nRemove all edges from the matching."},
+  {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Graph_getset[] = {
+  {"nodes", (getter) Graph_get_nodes, NULL, "number of nodes", NULL},
+  {"edges", (getter) Graph_get_edges, NULL, "number of edges", NULL},
+  {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject GraphType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "matching.Graph",
+  .tp_doc = "Graph(n=0, edges=None)\n\nReusable bipartite graph with its matching.",
+  .tp_basicsize = sizeof(GraphObject),
+  .tp_itemsize = 0,
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_new = PyType_GenericNew,
+  .tp_init = (initproc) Graph_init,
+  .tp_dealloc = (destructor) Graph_dealloc,
+  .tp_methods = Graph_methods,
+  .tp_getset = Graph_getset,
+};
+
+//------------------------------------------------------------------- MODULE
+
+static PyObject *matching_match(PyObject *module, PyObject *args, PyObject *kwds) {
+
+  static char *keywords[] = {"n", "edges", "threads", "engine", NULL};
+  const char *name = "parallel";
+  PyObject *edges = NULL;
+  int n = 0, threads = 1, engine = PARALLEL;
+
+  (void) module;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "iO|is", keywords, &n, &edges, &threads, &name)) {
+    return NULL;
+  }
+
+  if (parseEngine(name, &engine) != 0) {
+    return NULL;
+  }
+
+  // match a temporary graph
+  GraphObject *graph = (GraphObject*) PyObject_CallObject((PyObject*) &GraphType, NULL);
+  if (graph == NULL) {
+    return NULL;
+  }
+
+  PyObject *result = NULL;
+  if (setEdges(graph, n, edges) == 0) {
+    result = matchAndGetMates(graph, engine, threads);
+  }
+
+  Py_DECREF(graph);
+  return result;
+}
+
+//-------------------------------------------------------------------
+
+static PyMethodDef matching_methods[] = {
+  {"match", (PyCFunction)(void(*)(void)) matching_match, METH_VARARGS | METH_KEYWORDS,
+   "match(n, edges, threads=1, engine='parallel')\n\nReturn mates of a maximum matching."},
+  {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef matching_module = {
+  PyModuleDef_HEAD_INIT,
+  .m_name = "matching",
+  .m_doc = "Maximum matching in bipartite graphs.",
+  .m_size = -1,
+  .m_methods = matching_methods,
+};
+
+PyMODINIT_FUNC PyInit_matching(void) {
+
+  if (PyType_Ready(&GraphType) < 0) {
+    return NULL;
+  }
+
+  PyObject *module = PyModule_Create(&matching_module);
+  if (module == NULL) {
+    return NULL;
+  }
+
+  Py_INCREF(&GraphType);
+  if (PyModule_AddObject(module, "Graph", (PyObject*) &GraphType) < 0) {
+    Py_DECREF(&GraphType);
+    Py_DECREF(module);
+    return NULL;
+  }
+
+  // mates are returned as NumPy arrays when NumPy is available
+  numpy = PyImport_ImportModule("numpy");
+  if (numpy == NULL) {
+    PyErr_Clear();
+  }
+
+  return module;
+}
+
+/* end of file */
@@ -0,0 +1,26 @@
+#
+# GAL 2014
+# Python bindings of libmatching
+#
+# Build:
+# make -C ../lib
+# python setup.py build_ext --inplace
+#
+
+from setuptools import setup, Extension
+
+matching = Extension(
+  "matching",
+  sources = ["matchingmodule.c"],
+  include_dirs = ["../lib"],
+  extra_objects = ["../lib/libmatching.a"],
+  libraries = ["pthread", "m"],
+  extra_compile_args = ["-std=c99", "-Wall", "-W"]
+)
+
+setup(
+  name = "matching",
+  version = "1.0",
+  description = "Maximum matching in bipartite graphs",
+  ext_modules = [matching]
+)
@@ -5,497 +5,255 @@
  * Date:    13.11.2014
  */
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../lib/internal.h"
 
 #define IFDEBUG(y) //y;
-#define DEBUG(x)   //fprintf(stderr, "DEBUG: " x "\n");
-
-//------------------------------------------------------------------- ENUMS
-
-enum errors {
-  EOK = 0,
-  EPARAM,
-  EFILE,
-  EINPUT,
-  EALLOC,
-  EQUEUE,
-  EUNKNOWN
-};
-
-enum treestat {
-  NONE = 0,
-  ACTUAL,
-  APSTREE
-};
-
-//------------------------------------------------------------------- TYPES
-
-typedef struct tGraph TGraph;
-typedef struct tTree TTree;
-typedef struct tNode TNode;
-typedef struct tEdge TEdge;
-typedef struct tQueue TQueue;
-typedef struct tItem TItem;
-
-
-struct tGraph {
-  int n;
-  int m;
-  TNode *nodes;
-  TTree *trees;
-};
-
-struct tTree {
-  int status;
-  TNode *root;
-  TTree *next;
-};
-
-struct tNode {
-  int id;
-  TEdge *edges;
-  TEdge *entry;
-  TTree *tree;
-};
-
-struct tEdge {
-  int M;
-  TNode *node;
-  TEdge *reversed;
-  TEdge *next;
-};
-
-struct tQueue {
-  TItem *first;
-  TItem *last;
-};
-
-struct tItem {
-  void *item;
-  TItem *next;
-};
-
-//------------------------------------------------------------------- QUEUE
-
-void initQueue(TQueue *Q) {
-  Q->first = NULL;
-  Q->last = NULL;
-}
+#define MAXPATH    4096
 
-int isEmpty(TQueue *Q) {
-  return (Q->first == NULL);
-}
+//------------------------------------------------------------------- MATCHING
 
-int enqueue(TQueue *Q, void *item) {
-  
-  TItem *qitem = malloc(sizeof(TItem));
-  if (qitem == NULL) {
-    return EALLOC;
-  }
-  
-  qitem->item = item;
-  qitem->next = NULL;
-  
-  if (Q->first == NULL) {
-    Q->first = qitem;
-  }
+int runMatching(char *fname, char *init, TLimits *limits, int verify, int format, int counters) {
 
-  if (Q->last != NULL) {
-    Q->last->next = qitem;
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
   }
-  
-  Q->last = qitem;
-  
-  return EOK;
-}
 
-void* dequeue(TQueue *Q) {
-  
-  if (isEmpty(Q)) {
-    return NULL;
-  }
-  
-  void *item = Q->first->item;
-  
-  TItem *old = Q->first;
-  Q->first = Q->first->next;
-  
-  if (Q->first == NULL) {
-    Q->last = NULL;
+  // hardware counters of the phases, per edge of the graph
+  TPerf perf;
+  if (counters) {
+    initPerf(&perf);
+    beginPerf(&perf, NULL);
   }
-  
-  free(old);
-  return item;
-}
 
-void freeQueue(TQueue *Q) {
-  while(!isEmpty(Q)) dequeue(Q);
-}
+  // load graph
+  TGraph graph;
+  int error = loadGraph(&graph, f);
+  fclose(f);
 
-//------------------------------------------------------------------- GRAPH
+  if (counters && error == EOK) {
+    endPerf(&perf, NULL, LOAD, (uint64_t) graph.m);
+  }
 
-int initGraph(TGraph *graph, int n) {
+  // seed the matching
+  if (error == EOK && init != NULL) {
 
-  // init graph
-  graph->n = n;
-  graph->m = 0;
-  graph->trees = NULL;
-  graph->nodes = malloc(n * sizeof(TNode));
-  
-  if(graph->nodes == NULL) {
-    return EALLOC;
-  }
-  
-  // init nodes
-  TNode *node = NULL;
-  for(int i = 0; i < n; i++) {\
-    node = &(graph->nodes[i]);
-
-    node->id = i;
-    node->edges = NULL;
-    node->entry = NULL;
-    node->tree = NULL;    
+    FILE *m = fopen(init, "r");
+    error = (m != NULL) ? loadMatching(&graph, m) : EFILE;
+    if (m != NULL) fclose(m);
   }
-  
-  return EOK;
-}
 
-//-------------------------------------------------------------------
+  if (error == EOK) {
+
+    // print graph
+    IFDEBUG(printGraph(&graph, stderr))
 
-void freeGraph(TGraph *graph) {
+    // find matching
+    if (counters) beginPerf(&perf, NULL);
+    error = findMatchingSequenceBounded(&graph, limits);
 
-  // free edges  
-  for(int i=0; i < graph->n; i++) {
-    TNode *node = &(graph->nodes[i]);
-    TEdge *edge = node->edges;
-    
-    while (edge != NULL) {
-      TEdge *old = edge;
-      edge = edge->next;
-      free(old);
+    if (error == EOK && counters) {
+      endPerf(&perf, NULL, MATCH, (uint64_t) graph.m);
+      beginPerf(&perf, NULL);
     }
-  }
-  
-  // free nodes
-  free(graph->nodes);
-  
-  // free trees
-  TTree *tree = graph->trees;
-  while(tree != NULL) {
-    TTree *old = tree;
-    tree = tree->next;
-    free(old);
-  }
-  
-}
 
-//-------------------------------------------------------------------
+    if (error == EOK) {
 
-int addEdge(TGraph *graph, int idA, int idB) {
+      // print matching
+      error = writeMatching(NULL, &graph, format, stdout);
+    }
 
-  // check input
-  if (idA == idB || idA >= graph->n || idB >= graph->n) {
-    return EINPUT;
+    if (error == EOK && counters) {
+      endPerf(&perf, NULL, OUTPUT, (uint64_t) graph.m);
+    }
   }
 
-  // get nodes
-  TNode *A = &(graph->nodes[idA]);
-  TNode *B = &(graph->nodes[idB]);
-    
-  // allocate edges
-  TEdge *edgeAB = malloc(sizeof(TEdge));
-  TEdge *edgeBA = malloc(sizeof(TEdge));
-  
-  if (edgeAB == NULL || edgeBA == NULL) {
-    return EALLOC;  
+  if (counters) {
+    if (error == EOK) printPerf(&perf, stderr);
+    freePerf(&perf);
   }
-  
-  // init edge from A to B
-  edgeAB->M = 0;
-  edgeAB->node = B;
-  edgeAB->reversed = edgeBA;
-  edgeAB->next = A->edges;
-  A->edges = edgeAB;
-  
-  // init edge from B to A
-  edgeBA->M = 0;
-  edgeBA->node = A;
-  edgeBA->reversed = edgeAB;
-  edgeBA->next = B->edges;
-  B->edges = edgeBA;
-  
-  graph->m++;
 
-  return EOK;
-}
+  // prove the matching is maximum
+  if (error == EOK && verify) {
 
-//-------------------------------------------------------------------
+    TCertificate cert;
+    TDecomposition dm = {0};
+    error = verifyMatching(NULL, &graph, &cert);
 
-int loadGraph(TGraph *graph, FILE *f) {
+    if (error == EOK) {
+      fprintf(stdout, "\n");
+      printCertificate(&cert, stdout);
+      error = cert.verified ? EOK : EINTERN;
+    }
 
-  // init
-  int n = 0, m = 0, x = 0, y = 0;
-  
-  // read numbers of vertices and edges
-  if(fscanf(f, "%d %d", &n, &m) != 2) {
-    return EINPUT;
-  }
+    // the blocks reuse the sides and the cover of the certificate
+    if (error == EOK && verify == DECOMPOSE) {
+      error = decomposeMatching(NULL, &graph, &cert, &dm);
+    }
 
-  // init graph
-  initGraph(graph, n);
-  
-  // read edges
-  for (int i = 1; i <= m; i++) {
-  
-    if(fscanf(f, "%d %d", &x, &y) != 2) {
-      return EINPUT;
+    if (error == EOK && verify == DECOMPOSE) {
+      fprintf(stdout, "\n");
+      error = printDecomposition(&dm, stdout);
     }
-    
-    addEdge(graph, x, y);
+
+    freeDecomposition(&dm);
+    freeCertificate(&cert);
   }
-    
-  return EOK;
+
+  freeGraph(&graph);
+  return error;
 }
 
-//-------------------------------------------------------------------
+//------------------------------------------------------------------- BENCH
 
-void printGraph(TGraph *graph, FILE *f) {
+int runBench(char *fname, int trials) {
 
-  fprintf(f, "<Graph>\n");
-  for(int i = 0; i < graph->n; i++) {
-  
-    TNode *node = &(graph->nodes[i]);
-    if (node != NULL) {
-    
-      fprintf(f, "Node %d: ", node->id);  
-
-      TEdge *edge = node->edges;      
-      while(edge != NULL) {
-      
-        fprintf(f, "%d[%d] ", edge->node->id, edge->M);  
-        edge = edge->next;
-      }
-      
-      fprintf(f, "\n");  
-    }
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
   }
-}
 
-//-------------------------------------------------------------------
+  // the graph is loaded once
+  TGraph graph;
+  TBench bench;
+  uint64_t start = traceClock();
+  int error = loadGraph(&graph, f);
+  fclose(f);
 
-void printMatching(TGraph *graph, FILE *f) {
+  if (error != EOK) {
+    return error;
+  }
 
-  int M = 0;
-  fprintf(f, "<Matching>\n");
-  
-  // print edges in matching
-  for(int i = 0; i < graph->n; i++) {
-  
-    TNode *node = &(graph->nodes[i]);
-    if (node != NULL) {
-    
-      TEdge *edge = node->edges;      
-      while(edge != NULL) {
-        
-        if (node->id < edge->node->id && edge->M) {      
-          fprintf(f, "(%d,%d) ", node->id, edge->node->id); 
-          M++;
-        }
+  error = initBench(&bench, trials);
+  addSample(&bench, LOAD, traceClock() - start);
 
-        edge = edge->next;
-      }
-    }
+  if (error == EOK) {
+    error = benchMatching(NULL, &graph, &bench);
   }
-  
-  if (M != 0) {
-    fprintf(f, "\n\n");  
+
+  if (error == EOK) {
+    printBench(&bench, "sequence", fname, 1, stdout);
   }
 
-  fprintf(f, "<Nodes>\n%d\n\n", graph->n);
-  fprintf(f, "<Edges>\n%d\n\n", graph->m);
-  fprintf(f, "<M>\n%d\n", M);  
+  freeBench(&bench);
+  freeGraph(&graph);
+  return error;
 }
 
-//------------------------------------------------------------------- TREE
+//------------------------------------------------------------------- COMPRESSED
 
-TTree *createTree(TGraph *graph) {
+int runCompressed(char *fname) {
 
-  // allocate tree
-  TTree *tree = malloc(sizeof(TTree));
-  if (tree == NULL) {
-    return NULL;
+  // open file
+  FILE *f = fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
   }
-  
-  // init tree
-  tree->status = ACTUAL;
-  tree->root = NULL;
-  tree->next = graph->trees;
-  graph->trees = tree;
-  
-  return tree;
-}
 
+  // load graph with compressed adjacency
+  TCompressed graph;
+  int error = loadCompressed(&graph, f);
+  fclose(f);
 
-int inAPSTree (TNode *x) {
-  return (x->tree != NULL && x->tree->status == APSTREE);
-}
+  // find and print matching
+  if (error == EOK) {
+    error = findMatchingCompressed(&graph);
+  }
 
-//------------------------------------------------------------------- 
-
-void processPath(TTree *tree, TNode *end) {
-
-  TNode *u, *v;
-  TEdge *uv, *vu;
-    
-  u = end;
-       
-  while (u != tree->root) {
-   
-    vu = u->entry;
-    uv = vu->reversed;
-    v  = uv->node;
-      
-    vu->M = !(vu->M);
-    uv->M = !(uv->M);
-      
-    u = v;
+  if (error == EOK) {
+    printCompressed(&graph, stdout);
   }
-    
-  tree->status = NONE;
-}
 
-//------------------------------------------------------------------- APPLY APS
+  freeCompressed(&graph);
+  return error;
+}
 
-int _applyAPS(TTree *tree, TQueue *Q) {
+//------------------------------------------------------------------- EXTERNAL
 
-  DEBUG("Apply APS.")
-  
-  int error = EOK;  
-  int yM = 0, foundPath = 0;
-  
-  TNode *x, *y, *z, *pathEnd = NULL;
-  TEdge *xy, *yz;
+#define BUDGET 256
 
-  // insert root into Q
-  error = enqueue(Q, (void*) tree->root);
-  if (error != EOK) return error;
-  
-  // while Q is not empty and no path found
-  while(!isEmpty(Q) && !foundPath) {
+int runExternal(char *fname, char *adjacency, size_t budget) {
 
-    // get x
-    x = dequeue(Q);    
-    xy = x->edges;
+  TCompressed graph;
+  TPhase build = {0, 0, 0};
+  int error = EOK;
 
-    while(xy != NULL && !foundPath) {
+  // sort the lists into the adjacency file
+  if (fname != NULL) {
 
-      // get y
-      y = xy->node;
-      if (y->tree == tree || inAPSTree(y)) {
-        xy = xy->next;
-        continue;
-      }
+    FILE *f = fopen(fname, "r");
+    if (f == NULL) {
+      return EFILE;
+    }
 
-      y->tree = tree;
-      y->entry = xy;
-      yM = 0;
-      
-      yz = y->edges;
-      while(yz != NULL) {
-            
-        // get z
-        z = yz->node;
-        if (!(yz->M) || (z->tree == tree) || inAPSTree(z)) {
-          yz = yz->next;
-          continue;
-        }
+    error = writeAdjacency(f, adjacency, budget, &build);
+    fclose(f);
+  }
 
-        z->tree = tree;
-        z->entry = yz;
-        yM = 1;
-        
-        // add z to Q
-        error = enqueue(Q, (void*) z);
-        if (error != EOK) return error;
-        
-        // get next edge
-        yz = yz->next;
-      }    
-      
-      // y is not in M, we found a path
-      if (!yM) {  
-        foundPath = 1;
-        pathEnd = y;
-      }
-      
-      // get next edge
-      xy = xy->next;      
-    }
+  if (error != EOK) {
+    return error;
   }
-  
-  // we found M-path, change M
-  if(foundPath) {
-    processPath(tree, pathEnd);
+
+  // map the file, only mates and trees are kept in memory
+  error = mapCompressed(&graph, adjacency);
+  graph.phases[BUILD] = build;
+
+  if (error == EOK) {
+    error = findMatchingCompressed(&graph);
   }
-  
-  // we found APS-tree
-  else {
-    tree->status = APSTREE;
+
+  if (error == EOK) {
+    printCompressed(&graph, stdout);
   }
 
-  DEBUG("Finished apply APS.")
-  return EOK;
+  freeCompressed(&graph);
+  return error;
 }
 
-int applyAPS(TTree *tree) {
+//------------------------------------------------------------------- STREAM
 
-  TQueue Q;
-  initQueue(&Q);
-  
-  int error = _applyAPS(tree, &Q);
+#define EPS 0.1
+
+int runStream(char *fname, int passes, double eps) {
+
+  // the greedy pass alone can read the standard input
+  FILE *f = (strcmp(fname, "-") == 0) ? stdin : fopen(fname, "r");
+  if (f == NULL) {
+    return EFILE;
+  }
 
-  freeQueue(&Q);
+  TStream stream;
+  int error = matchStream(&stream, f, passes, eps);
+
+  if (error == EOK) {
+    printStream(&stream, stdout);
+  }
+
+  freeStream(&stream);
+  if (f != stdin) fclose(f);
   return error;
 }
 
-//------------------------------------------------------------------- FIND MATCHING
+//------------------------------------------------------------------- WIDE
 
-int findMatching(TGraph *graph) {
+void runWide(char *argv[]) {
 
-  int error = EOK;
-  
-  for (int i = 0; i < graph->n; i++) {
-    
-    // get node
-    TNode *node = &(graph->nodes[i]);
-
-    if (node != NULL) {
-     
-      // does it belongs to M?
-      TEdge *edge = node->edges;
-      while((edge != NULL) && !(edge->M)) {
-        edge = edge->next;
-      }
+#ifndef INDEX64
+  // the graph needs 64-bit ids, run the same command in matching64
+  char path[MAXPATH];
 
-      // yes, then skip this node.
-      if (edge != NULL) continue;
-    
-      // create tree
-      TTree *tree = createTree(graph);
-      if (tree == NULL) return EALLOC;
-      
-      tree->root = node; 
-      node->tree = tree;
-      
-      // find augmenting path
-      error = applyAPS(tree);
-      if (error != EOK) return error;
-    
-    }  
+  if (snprintf(path, MAXPATH, "%s64", argv[0]) < MAXPATH) {
+    argv[0] = path;
+    execvp(path, argv);
   }
-
-  return EOK;
+#else
+  (void) argv;
+#endif
 }
 
 //------------------------------------------------------------------- MAIN
@@ -505,38 +263,100 @@ int main (int argc, char *argv[])
   int error = EOK;
   
   // check params
-  if (argc == 2) {
-  
-    // open file
-    FILE *f = fopen(argv[1], "r");
-    if (f != NULL) {
-  
-      // load graph
-      TGraph graph;      
-      error = loadGraph(&graph, f);
-      if (error == EOK) {
-      
-        // print graph
-        IFDEBUG(printGraph(&graph, stderr))
-        
-        // find matching
-        error = findMatching(&graph);
-        if (error == EOK) {
-        
-          // print matching
-          printMatching(&graph, stdout);
+  if (argc == 3 && strcmp(argv[2], "--compressed") == 0) {
+
+    // find matching on compressed adjacency
+    error = runCompressed(argv[1]);
+  }
+  else if (argc == 3 && strcmp(argv[2], "--mapped") == 0) {
+
+    // find matching on a mapped adjacency file
+    error = runExternal(NULL, argv[1], 0);
+  }
+  else if ((argc == 3 || argc == 4) && strcmp(argv[2], "--bench") == 0) {
+
+    // time the phases of warm runs
+    int trials = (argc == 4) ? atoi(argv[3]) : BENCH_TRIALS;
+    error = (trials > 0) ? runBench(argv[1], trials) : EPARAM;
+  }
+  else if (argc >= 3 && argc <= 5 && strcmp(argv[2], "--stream") == 0) {
+
+    // maximal matching in one pass, augmentations in the next passes
+    int passes = (argc >= 4) ? atoi(argv[3]) : 0;
+    double eps = (argc == 5) ? atof(argv[4]) : EPS;
+    error = (passes >= 0) ? runStream(argv[1], passes, eps) : EPARAM;
+  }
+  else if ((argc == 4 || argc == 5) && strcmp(argv[2], "--external") == 0) {
+
+    // build the adjacency file within the budget in MB
+    int budget = (argc == 5) ? atoi(argv[4]) : BUDGET;
+    error = (budget > 0) ? runExternal(argv[1], argv[3], (size_t) budget << 20) : EPARAM;
+  }
+  else if (argc >= 2) {
+
+    // options
+    char *init = NULL;
+    struct timespec deadline;
+    TLimits limits = {NULL, 0, 1};
+    int bounded = 0;
+    int verify = NOCHECK;
+    int format = TEXT;
+    int counters = 0;
+
+    for (int i = 2; i < argc && error == EOK; i++) {
+
+      if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+        init = argv[++i];
+      }
+      else if (strcmp(argv[i], "--counters") == 0) {
+        counters = 1;
+      }
+      else if (strcmp(argv[i], "--binary") == 0) {
+        format = BINARY;
+      }
+      else if (strcmp(argv[i], "--quiet") == 0) {
+        format = QUIET;
+      }
+      else if (strcmp(argv[i], "--verify") == 0) {
+        verify = VERIFY;
+      }
+      else if (strcmp(argv[i], "--decompose") == 0) {
+        verify = DECOMPOSE;
+      }
+      else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc) {
+        initDeadline(&deadline, atof(argv[++i]));
+        limits.deadline = &deadline;
+        bounded = 1;
+      }
+      else if (strcmp(argv[i], "--max-path-length") == 0 && i + 1 < argc) {
+        limits.length = atoi(argv[++i]);
+        bounded = 1;
+
+        if (limits.length <= 0) {
+          error = EPARAM;
         }
-      }    
-      freeGraph(&graph);
-      fclose(f);
+      }
+      else {
+        error = EPARAM;
+      }
     }
-    else {
-      error = EFILE;
+
+    // the binary output takes no sections after it
+    if (error == EOK && !(format == BINARY && verify)) {
+      error = runMatching(argv[1], init, bounded ? &limits : NULL, verify, format, counters);
+    }
+    else if (error == EOK) {
+      error = EPARAM;
     }
   }
   else {
     error = EPARAM;
   }
+
+  // the variant is chosen by the header of the graph
+  if (error == EINDEX) {
+    runWide(argv);
+  }
   
   if (error != EOK) {
     fprintf(stderr, "ERROR %d\n", error);
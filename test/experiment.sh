@@ -2,6 +2,8 @@
 
 # Measure the execution time for the sequence and the parallel versions
 # for the generated input and the given numbers of processors and threads.
+# The rows PARALLEL;n;e;proc;threads;time; are followed by the speedup,
+# the parallel efficiency and the size of the matching.
 
 MAXPROC=12
 MAXTHREAD=15 
@@ -13,36 +15,12 @@ MAXTHREAD=15
 (cd ../parallel/ && make)
 
 # init
-TIMEFORMAT='%3R'
-time="time.out"
 results="results.out"
 echo "TEST `date`" >> $results
 
-# testing
+# testing, the sweep loads every graph once
 for file in ./files/graph_* ; do
 
-  n=`head -n 1 $file`
-  e=`head -n 2 $file | tail -n 1`
-  
-  (time taskset -c 0-11 ../sequence/matching $file ) >/dev/null 2>$time
-
-  t=`head -n 1 $time`        
-  line="SEQUENCE;$n;$e;1;1;$t;"
-  echo $line >> $results 
-  echo $line
-  
-  for proc in $(seq 0 $MAXPROC); do
-	    for threads in $(seq 1 $MAXTHREAD); do  
-	      	      
-  	    (time taskset -c 0-$proc ../parallel/matching $file $threads ) >/dev/null 2>$time
-
-        t=`head -n 1 $time`
-        line="PARALLEL;$n;$e;$proc;$threads;$t;"   
-        echo $line >> $results 
-        echo $line
-        	    
-      done
-   done
-done
+  ../parallel/matching --sweep $file 1-$MAXTHREAD 0-$MAXPROC | tee -a $results
 
-rm -f time.out
+done
@@ -0,0 +1,176 @@
+#!/bin/bash
+
+# Performance regression of the engines on a fixed generated corpus.
+# Every engine benchmarks every graph in-process, the sizes of their
+# matchings must agree and the fastest trials of the PHASES are compared
+# with the baseline, the minimum is the least noisy. A phase slower by
+# more than THRESHOLD percent and by more than FLOOR ms is measured again
+# up to RETRIES times with more trials, it fails the run when none of the
+# new trials is fast enough. A run without a row in the baseline fails too. The parallel
+# engines run with each of the fixed THREADS, not with the processors of
+# the machine, so that the keys of the baseline stay the same everywhere.
+# The default THREADS are the counts of the committed baseline, record
+# more with UPDATE=1 THREADS="1 2 4". Counts above the processors are
+# skipped, the spinning threads would only wait.
+# UPDATE=1 writes the baseline of this machine instead.
+#
+# Usage: [THRESHOLD=25] [FLOOR=1] [TRIALS=10] [RETRIES=5] [THREADS="1"] [PHASES="match load"]
+#        [UPDATE=1] ./regress.sh
+
+THRESHOLD=${THRESHOLD:-25}
+FLOOR=${FLOOR:-1}
+TRIALS=${TRIALS:-10}
+RETRIES=${RETRIES:-5}
+PHASES=${PHASES:-match}
+THREADS=${THREADS:-"1"}
+BASELINE=${BASELINE:-baseline.csv}
+ENGINES=${ENGINES:-"sequence parallel"}
+DIR="regress"
+
+# the fixed counts that the machine can run at once
+PROCS=`nproc`
+RUN=""
+
+for n in $THREADS; do
+  if [ $n -gt $PROCS ]; then
+    echo "WARNING: $n threads skipped, only $PROCS processors, the rows of $n threads are not checked"
+  else
+    RUN="$RUN $n"
+  fi
+done
+
+# one CSV of the benchmark per engine and count of threads, add new engines here
+run_once() {
+  case $1 in
+    sequence) ../sequence/matching $2 --bench $TRIALS ;;
+    parallel) ../parallel/matching --bench $2 $3 $TRIALS ;;
+    *) echo "unknown engine $1" >&2; return 1 ;;
+  esac
+}
+
+run_engine() {
+  case $1 in
+    sequence) run_once $1 $2 1 ;;
+    *)
+      for n in $RUN; do
+        run_once $1 $2 $n || return 1
+      done ;;
+  esac
+}
+
+# the corpus, fixed seeds
+mkdir -p $DIR
+G=../graph/generator
+
+[ -f $DIR/er ]       || $G er 5000 5000 0.002 --seed 1 > $DIR/er
+[ -f $DIR/chunglu ]  || $G chunglu 5000 5000 5 2.5 --seed 2 > $DIR/chunglu
+[ -f $DIR/rmat ]     || $G rmat 4096 4096 40000 --seed 3 > $DIR/rmat
+[ -f $DIR/grid ]     || $G grid 150 150 --seed 4 > $DIR/grid
+[ -f $DIR/road ]     || $G road 200 200 0.6 --seed 5 > $DIR/road
+[ -f $DIR/hk ]       || $G hk 200 --seed 6 > $DIR/hk
+[ -f $DIR/conflict ] || $G conflict 10000 10 --seed 7 > $DIR/conflict
+
+# engine,graph,threads,M,stable,phase,min_ms of every run
+results=$DIR/results.csv
+: > $results
+failed=0
+
+for file in $DIR/er $DIR/chunglu $DIR/rmat $DIR/grid $DIR/road $DIR/hk $DIR/conflict; do
+
+  name=`basename $file`
+  sizes=""
+
+  for engine in $ENGINES; do
+
+    rows=`set -o pipefail; run_engine $engine $file | grep -v '^engine,'`
+    if [ $? -ne 0 ] || [ -z "$rows" ]; then
+      echo "FAIL $engine $name: no result"
+      failed=1
+      continue
+    fi
+
+    echo "$rows" | awk -F, -v g=$name 'BEGIN {OFS = ","} {print $1, g, $3, $4, $5, $6, $9}' >> $results
+    sizes="$sizes `echo "$rows" | cut -d, -f4 | sort -u`"
+
+    # every trial of an engine finds the same size
+    if echo "$rows" | grep -q '^[^,]*,[^,]*,[^,]*,[^,]*,0,'; then
+      echo "FAIL $engine $name: unstable matching size"
+      failed=1
+    fi
+  done
+
+  # and so do all engines
+  if [ `echo $sizes | tr ' ' '\n' | sort -u | wc -l` -gt 1 ]; then
+    echo "FAIL $name: matching sizes differ:$sizes"
+    failed=1
+  fi
+done
+
+# store the baseline
+if [ -n "$UPDATE" ]; then
+  echo "engine,graph,threads,phase,min_ms" > $BASELINE
+  awk -F, 'BEGIN {OFS = ","} {print $1, $2, $3, $6, $7}' $results >> $BASELINE
+  echo "Baseline written to $BASELINE."
+  exit $failed
+fi
+
+if [ ! -f $BASELINE ]; then
+  echo "No baseline $BASELINE, run with UPDATE=1."
+  exit 1
+fi
+
+# compare the fastest trials, runs without a baseline row fail,
+# the keys of the slow runs go to the file $2
+compare() {
+  awk -F, -v threshold=$THRESHOLD -v floor=$FLOOR -v phases=" $PHASES " -v out=$1 -v slowfile=$2 '
+    BEGIN {OFS = ","; failed = 0; printf "" > slowfile}
+    NR == FNR { if (FNR > 1) base[$1 "," $2 "," $3 "," $4] = $5; next }
+    index(phases, " " $6 " ") == 0 { next }
+    {
+      key = $1 "," $2 "," $3 "," $6
+      if (!(key in time)) { keys[++count] = key; time[key] = $7 }
+      if ($7 < time[key]) time[key] = $7
+    }
+    END {
+      for (i = 1; i <= count; i++) {
+        key = keys[i]
+        if (!(key in base)) {
+          if (out) printf "MISS %-40s %10.3f ms no baseline\n", key, time[key]
+          failed = 1
+          continue
+        }
+        old = base[key]
+        change = (old > 0) ? 100 * (time[key] - old) / old : 0
+        slow = (time[key] - old > floor && change > threshold)
+        if (out) printf "%s %-40s %10.3f ms %10.3f ms %+8.1f %%\n", (slow ? "SLOW" : "OK  "), key, old, time[key], change
+        if (slow) { print key > slowfile; failed = 1 }
+      }
+      exit failed
+    }
+  ' $BASELINE $results
+}
+
+# a slow run is measured again with more trials, the other load of a noisy
+# machine comes in bursts and only slows the trials down, the fastest wins
+slow=$DIR/slow
+retry=0
+
+while ! compare 0 $slow && [ -s $slow ] && [ $retry -lt $RETRIES ]; do
+
+  retry=$((retry + 1))
+
+  while IFS=, read engine name threads phase; do
+    echo "RETRY $engine,$name,$threads,$phase ($retry of $RETRIES)"
+    TRIALS=$((TRIALS * 2 * retry)) run_once $engine $DIR/$name $threads | grep -v '^engine,' \
+      | awk -F, -v g=$name 'BEGIN {OFS = ","} {print $1, g, $3, $4, $5, $6, $9}' >> $results
+  done < $slow
+done
+
+compare 1 $slow || failed=1
+
+if [ $failed -ne 0 ]; then
+  echo "Regression."
+  exit 1
+fi
+
+echo "No regression."
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Test the parallel version on the conflict family, all roots share the
+# same right nodes and their trees hide each other. Every run must finish
+# in time with a maximum matching of the size of the sequence version.
+#
+# Usage: [THREADS="2 4 8"] [LIMIT=10] ./test_conflict.sh
+
+THREADS=${THREADS:-"2 4 8"}
+LIMIT=${LIMIT:-10}
+GRAPH=conflict.txt
+
+../graph/generator conflict 3000 10 --seed 1 > $GRAPH || exit 1
+expected=`../sequence/matching $GRAPH --quiet | tail -n 1`
+failed=0
+
+for n in $THREADS; do
+  for i in `seq 1 5`; do
+
+    # the matching proves itself maximum by a vertex cover of its size
+    timeout $LIMIT ../parallel/matching $GRAPH $n --verify >output 2>error
+    status=$?
+    size=`sed -n '/<M>/{n;p}' output`
+
+    if [ $status -ne 0 ] || [ "$size" != "$expected" ]; then
+      echo "FAIL $n threads: got '$size' expected $expected in $LIMIT s"
+      failed=1
+      break
+    fi
+  done
+done
+
+rm -f $GRAPH output error
+
+if [ $failed -ne 0 ]; then
+  exit 1
+fi
+
+echo "End."
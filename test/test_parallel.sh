@@ -8,13 +8,12 @@ do
   date=`date`
   echo -en "\r$i $date ";
   
-  ./matching ../graph/graph_1000_1000_100_1000 2 >output 2>error
-  #./matching ../graph/graph_8_8_55_8 3 >output 2>error
-  #./matching ../graph/graph_755_755_47_755 10 >output 2>error
+  # the matching proves itself maximum by a vertex cover of its size
+  ./matching ../graph/graph_1000_1000_100_1000 2 --verify >output 2>error
+  #./matching ../graph/graph_8_8_55_8 3 --verify >output 2>error
+  #./matching ../graph/graph_755_755_47_755 10 --verify >output 2>error
 
-  x=`tail -n 1 output`
-
-  if [ "$x" != "1000" ]; then
+  if [ $? -ne 0 ]; then
     echo "Found one!"
     break
   fi